@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "analysis.h"
+#include "utf8.h"
+
+// Work for one chunk of the document
+typedef struct {
+    const char *text;       // Whole text being analyzed
+    int start;              // Chunk start (index into text)
+    int end;                // Chunk end (exclusive)
+    int baseOffset;         // Document offset of text[0]
+    Trie *dictionary;       // Dictionary for the spelling pass (read-only)
+    int passes;             // ANALYSIS_* flags
+    AnalysisResult result;  // Per-chunk result buffer
+} AnalysisChunk;
+
+static ThreadPool analysisPool;
+static int analysisPoolReady = 0;
+static pthread_once_t analysisPoolOnce = PTHREAD_ONCE_INIT;
+
+static void createAnalysisPool(void) {
+    initThreadPool(&analysisPool, getDefaultThreadCount());
+    analysisPoolReady = 1;
+}
+
+// Shared pool used by all analysis passes (created on first use)
+ThreadPool* getAnalysisPool(void) {
+    pthread_once(&analysisPoolOnce, createAnalysisPool);
+    return &analysisPool;
+}
+
+// Stop the shared pool's workers (call once at exit)
+void shutdownAnalysisPool(void) {
+    if (analysisPoolReady) {
+        freeThreadPool(&analysisPool);
+        analysisPoolReady = 0;
+    }
+}
+
+// Append a misspelled word to a result buffer
+static void addMisspelled(AnalysisResult *r, const char *word, int start, int length,
+                          int *capacity) {
+    if (r->misspelledCount == *capacity) {
+        *capacity = (*capacity == 0) ? 16 : *capacity * 2;
+        r->misspelled = (MisspelledWord *)realloc(r->misspelled, *capacity * sizeof(MisspelledWord));
+    }
+    MisspelledWord w;
+    w.start = start;
+    w.length = length;
+    w.word = (char *)malloc(strlen(word) + 1);
+    strcpy(w.word, word);
+    r->misspelled[r->misspelledCount++] = w;
+}
+
+// Run the requested passes over one chunk
+// ALGORITHM: Single linear scan with the UTF-8 tokenizer; words are maximal
+// runs of letters, digits and combining marks
+static void analyzeChunk(void *arg) {
+    AnalysisChunk *c = (AnalysisChunk *)arg;
+    AnalysisResult *r = &c->result;
+    int misspelledCapacity = 0;
+    char word[SPELL_MAX_WORD];
+    
+    memset(r, 0, sizeof(AnalysisResult));
+    
+    // One read section per chunk; the dictionary can change meanwhile
+    int readSlot = -1;
+    TrieNode *dictionary = NULL;
+    if (c->passes & ANALYSIS_SPELLING) {
+        dictionary = beginTrieRead(c->dictionary, &readSlot);
+    }
+    
+    int wordStart;
+    int wordEnd;
+    int i = c->start;
+    while ((wordEnd = nextWord(c->text, c->end, i, &wordStart)) != -1) {
+        int wordLen = wordEnd - wordStart;
+        i = wordEnd;
+        
+        if (c->passes & ANALYSIS_WORDS) {
+            r->wordCount++;
+        }
+        if (c->passes & ANALYSIS_SPELLING) {
+            int copyLen = (wordLen < SPELL_MAX_WORD) ? wordLen : SPELL_MAX_WORD - 1;
+            memcpy(word, c->text + wordStart, copyLen);
+            word[copyLen] = '\0';
+            if (wordLen >= SPELL_MAX_WORD || !searchWordInSnapshot(dictionary, word)) {
+                addMisspelled(r, word, c->baseOffset + wordStart, wordLen, &misspelledCapacity);
+            }
+        }
+    }
+    
+    if (readSlot != -1) {
+        endTrieRead(c->dictionary, readSlot);
+    }
+}
+
+// Analyze text[0..length) whose first character is at document offset baseOffset
+// Large texts are split at word boundaries and processed on the shared pool
+void analyzeText(const char *text, int length, int baseOffset, Trie *dictionary,
+                 int passes, AnalysisResult *result) {
+    memset(result, 0, sizeof(AnalysisResult));
+    
+    int chunkCount = 1;
+    if (length >= ANALYSIS_PARALLEL_THRESHOLD) {
+        int threads = getAnalysisPool()->threadCount;
+        chunkCount = threads * 4;
+        if (length / chunkCount < ANALYSIS_MIN_CHUNK) {
+            chunkCount = length / ANALYSIS_MIN_CHUNK;
+        }
+        if (chunkCount < 1) {
+            chunkCount = 1;
+        }
+    }
+    
+    AnalysisChunk *chunks = (AnalysisChunk *)malloc(chunkCount * sizeof(AnalysisChunk));
+    
+    // Cut chunks at roughly equal sizes, moving each cut forward past the
+    // current word so no word is split between two chunks
+    int start = 0;
+    int used = 0;
+    for (int k = 0; k < chunkCount && start < length; k++) {
+        int end = (k == chunkCount - 1) ? length : (int)((long long)length * (k + 1) / chunkCount);
+        if (end < start) {
+            end = start;
+        }
+        while (end < length && isWordByte((unsigned char)text[end])) {
+            end++;
+        }
+        
+        AnalysisChunk *c = &chunks[used++];
+        c->text = text;
+        c->start = start;
+        c->end = end;
+        c->baseOffset = baseOffset;
+        c->dictionary = dictionary;
+        c->passes = passes;
+        start = end;
+    }
+    
+    if (used == 1) {
+        analyzeChunk(&chunks[0]);
+    } else if (used > 1) {
+        TaskGroup group;
+        initTaskGroup(&group);
+        for (int k = 0; k < used; k++) {
+            submitGroupTask(getAnalysisPool(), &group, analyzeChunk, &chunks[k]);
+        }
+        waitTaskGroup(&group);
+        freeTaskGroup(&group);
+    }
+    
+    // Merge per-chunk buffers in document order
+    for (int k = 0; k < used; k++) {
+        result->wordCount += chunks[k].result.wordCount;
+        result->misspelledCount += chunks[k].result.misspelledCount;
+    }
+    if (result->misspelledCount > 0) {
+        result->misspelled = (MisspelledWord *)malloc(result->misspelledCount * sizeof(MisspelledWord));
+    }
+    
+    int misspelledAt = 0;
+    for (int k = 0; k < used; k++) {
+        AnalysisResult *r = &chunks[k].result;
+        if (r->misspelledCount > 0) {
+            memcpy(result->misspelled + misspelledAt, r->misspelled, r->misspelledCount * sizeof(MisspelledWord));
+        }
+        misspelledAt += r->misspelledCount;
+        free(r->misspelled);
+    }
+    
+    free(chunks);
+}
+
+// Free a merged result, including the misspelled word strings
+void freeAnalysisResult(AnalysisResult *result) {
+    for (int i = 0; i < result->misspelledCount; i++) {
+        free(result->misspelled[i].word);
+    }
+    free(result->misspelled);
+    memset(result, 0, sizeof(AnalysisResult));
+}
@@ -0,0 +1,33 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "trie.h"
+#include "spellcache.h"
+#include "threadpool.h"
+
+// Parallel ANALYSIS DRIVER for full-document passes
+// Splits text into chunks at word boundaries, runs the requested passes on a
+// thread pool with one result buffer per chunk, and merges results in order
+
+// Passes (combine with |)
+#define ANALYSIS_WORDS    1   // Count words
+#define ANALYSIS_SPELLING 2   // Collect misspelled words
+
+#define ANALYSIS_PARALLEL_THRESHOLD (1 << 20)  // Smaller texts run inline
+#define ANALYSIS_MIN_CHUNK (256 * 1024)        // Smallest chunk handed to a worker
+
+// Merged result of all passes, offsets in document coordinates
+typedef struct {
+    int wordCount;               // ANALYSIS_WORDS
+    MisspelledWord *misspelled;  // ANALYSIS_SPELLING (words freed with the result)
+    int misspelledCount;
+} AnalysisResult;
+
+// Function declarations
+ThreadPool* getAnalysisPool(void);
+void analyzeText(const char *text, int length, int baseOffset, Trie *dictionary,
+                 int passes, AnalysisResult *result);
+void freeAnalysisResult(AnalysisResult *result);
+void shutdownAnalysisPool(void);
+
+#endif
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "coldtext.h"
+#include "huffman.h"
+
+// Initialize an empty cold text
+void initColdText(ColdText *cold) {
+    cold->chunks = NULL;
+    cold->chunkCount = 0;
+    cold->length = 0;
+    cold->compressedBytes = 0;
+}
+
+// Replace the contents of cold with a compressed copy of text
+// Each chunk gets its own code table, so text whose character mix changes
+// along the file (code, then a long comment, then data) still codes well
+void compressColdText(ColdText *cold, const char *text, int length) {
+    freeColdText(cold);
+    cold->length = length;
+    cold->chunkCount = (length + COLD_CHUNK_SIZE - 1) / COLD_CHUNK_SIZE;
+    cold->chunks = (ColdChunk *)malloc((cold->chunkCount > 0 ? cold->chunkCount : 1) * sizeof(ColdChunk));
+    
+    unsigned char *buffer = (unsigned char *)malloc(huffman_max_compressed_size(COLD_CHUNK_SIZE));
+    for (int i = 0; i < cold->chunkCount; i++) {
+        int start = i * COLD_CHUNK_SIZE;
+        int chunkLength = (length - start < COLD_CHUNK_SIZE) ? length - start : COLD_CHUNK_SIZE;
+        int size = huffman_compress((const unsigned char *)text + start, chunkLength, buffer,
+                                    huffman_max_compressed_size(COLD_CHUNK_SIZE));
+    
+        // Exact-size copy: the coder needs slack while writing, the chunk does not
+        cold->chunks[i].data = (unsigned char *)malloc(size);
+        memcpy(cold->chunks[i].data, buffer, size);
+        cold->chunks[i].size = size;
+        cold->compressedBytes += size;
+    }
+    free(buffer);
+}
+
+// Copy length bytes starting at start into out, decoding only the chunks
+// the range touches; returns the number of bytes copied (clipped to the
+// text), or -1 if a chunk is corrupt
+int readColdRange(const ColdText *cold, int start, int length, char *out) {
+    if (start < 0 || start >= cold->length || length <= 0) {
+        return 0;
+    }
+    if (length > cold->length - start) {
+        length = cold->length - start;
+    }
+    
+    unsigned char *chunk = NULL;
+    int copied = 0;
+    while (copied < length) {
+        int position = start + copied;
+        int index = position / COLD_CHUNK_SIZE;
+        int offset = position % COLD_CHUNK_SIZE;
+        int chunkLength = huffman_decompressed_size(cold->chunks[index].data, cold->chunks[index].size);
+        int wanted = length - copied;
+    
+        if (offset == 0 && wanted >= chunkLength) {
+            // Whole chunk: decode straight into the destination
+            if (huffman_decompress(cold->chunks[index].data, cold->chunks[index].size,
+                                   (unsigned char *)out + copied, chunkLength) != chunkLength) {
+                free(chunk);
+                return -1;
+            }
+            copied += chunkLength;
+            continue;
+        }
+    
+        if (chunk == NULL) {
+            chunk = (unsigned char *)malloc(COLD_CHUNK_SIZE);
+        }
+        if (huffman_decompress(cold->chunks[index].data, cold->chunks[index].size,
+                               chunk, COLD_CHUNK_SIZE) != chunkLength) {
+            free(chunk);
+            return -1;
+        }
+        int n = (chunkLength - offset < wanted) ? chunkLength - offset : wanted;
+        memcpy(out + copied, chunk + offset, n);
+        copied += n;
+    }
+    free(chunk);
+    return copied;
+}
+
+// Decode the whole text into a new buffer (not null-terminated; at least
+// one byte even when empty), or NULL if a chunk is corrupt; caller frees
+char* expandColdText(const ColdText *cold) {
+    char *text = (char *)malloc(cold->length > 0 ? cold->length : 1);
+    if (readColdRange(cold, 0, cold->length, text) != cold->length) {
+        printf("Error: Compressed text is corrupt\n");
+        free(text);
+        return NULL;
+    }
+    return text;
+}
+
+// Free the chunks (cold is left empty and can be reused)
+void freeColdText(ColdText *cold) {
+    for (int i = 0; i < cold->chunkCount; i++) {
+        free(cold->chunks[i].data);
+    }
+    free(cold->chunks);
+    initColdText(cold);
+}
@@ -0,0 +1,34 @@
+#ifndef COLDTEXT_H
+#define COLDTEXT_H
+
+// COMPRESSED COLD TEXT for documents that are not being edited
+// The text is cut into fixed-size chunks and each chunk is Huffman-coded on
+// its own (src/c/huffman.c), so any range can be read back by decoding only
+// the chunks it covers
+
+#define COLD_CHUNK_SIZE 65536   // Uncompressed bytes per chunk (the last may be shorter)
+
+// One independently decodable chunk
+typedef struct {
+    unsigned char *data;   // huffman_compress output
+    int size;              // Bytes in data
+} ColdChunk;
+
+// Compressed text
+// DATA STRUCTURE: Array of chunks - chunk i holds text bytes
+// [i * COLD_CHUNK_SIZE, (i + 1) * COLD_CHUNK_SIZE), so finding a byte's chunk is O(1)
+typedef struct {
+    ColdChunk *chunks;
+    int chunkCount;
+    int length;            // Uncompressed bytes
+    long compressedBytes;  // Sum of the chunk sizes
+} ColdText;
+
+// Function declarations
+void initColdText(ColdText *cold);
+void compressColdText(ColdText *cold, const char *text, int length);
+int readColdRange(const ColdText *cold, int start, int length, char *out);
+char* expandColdText(const ColdText *cold);
+void freeColdText(ColdText *cold);
+
+#endif
@@ -1,122 +1,552 @@
+#define _DEFAULT_SOURCE   // realpath, strdup (POSIX, not declared under -std=c11)
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "deque.h"
 
+// Marks a filename index slot whose tab was removed (keeps probe chains intact)
+static Tab deletedMarker;
+#define INDEX_DELETED (&deletedMarker)
+
 // Initialize the tab deque
 void initTabDeque(TabDeque *dq) {
+    dq->capacity = TAB_INITIAL_CAPACITY;
+    dq->ring = (Tab **)calloc(dq->capacity, sizeof(Tab *));
     dq->front = 0;
     dq->rear = -1;
     dq->count = 0;
-    dq->currentTab = -1;
+    dq->current = NULL;
     
-    // Initialize all tabs
-    for (int i = 0; i < MAX_TABS; i++) {
-        dq->tabs[i].isActive = 0;
-        strcpy(dq->tabs[i].filename, "");
+    dq->indexCapacity = 16;
+    dq->index = (Tab **)calloc(dq->indexCapacity, sizeof(Tab *));
+    dq->indexUsed = 0;
+    
+    dq->lruHead = NULL;
+    dq->lruTail = NULL;
+    dq->residentBytes = 0;
+    dq->memoryBudget = TAB_MEMORY_BUDGET;
+    dq->compressSnapshots = 0;
+}
+
+// ========== RING BUFFER ==========
+
+// Position of a tab in the deque
+static int tabPosition(TabDeque *dq, Tab *tab) {
+    return (tab->slot - dq->front) & (dq->capacity - 1);
+}
+
+// Double the ring, laying the tabs out from slot 0
+static void growRing(TabDeque *dq) {
+    int newCapacity = dq->capacity * 2;
+    Tab **ring = (Tab **)calloc(newCapacity, sizeof(Tab *));
+    for (int i = 0; i < dq->count; i++) {
+        ring[i] = dq->ring[(dq->front + i) & (dq->capacity - 1)];
+        ring[i]->slot = i;
     }
+    free(dq->ring);
+    dq->ring = ring;
+    dq->capacity = newCapacity;
+    dq->front = 0;
+    dq->rear = dq->count - 1;
 }
 
-// Add a new tab
-int addTab(TabDeque *dq, const char *filename) {
-    if (dq->count >= MAX_TABS) {
-        printf("Maximum number of tabs reached (%d).\n", MAX_TABS);
-        return -1;
+// Append a tab at the rear - O(1) amortized
+static void pushBack(TabDeque *dq, Tab *tab) {
+    if (dq->count == dq->capacity) {
+        growRing(dq);
     }
-    
-    // Find first inactive tab slot
-    int tabIndex = -1;
-    for (int i = 0; i < MAX_TABS; i++) {
-        if (!dq->tabs[i].isActive) {
-            tabIndex = i;
-            break;
+    dq->rear = (dq->rear + 1) & (dq->capacity - 1);
+    dq->ring[dq->rear] = tab;
+    tab->slot = dq->rear;
+    dq->count++;
+}
+
+// Prepend a tab at the front - O(1) amortized
+static void pushFront(TabDeque *dq, Tab *tab) {
+    if (dq->count == dq->capacity) {
+        growRing(dq);
+    }
+    dq->front = (dq->front - 1) & (dq->capacity - 1);
+    dq->ring[dq->front] = tab;
+    tab->slot = dq->front;
+    dq->count++;
+}
+
+// Take the tab at a position out of the ring
+// ALGORITHM: Shift the shorter side by one - O(1) at either end, O(n/2) worst case
+static void removeAt(TabDeque *dq, int position) {
+    int mask = dq->capacity - 1;
+    if (position < dq->count / 2) {
+        for (int i = position; i > 0; i--) {
+            Tab *moved = dq->ring[(dq->front + i - 1) & mask];
+            dq->ring[(dq->front + i) & mask] = moved;
+            moved->slot = (dq->front + i) & mask;
+        }
+        dq->ring[dq->front] = NULL;
+        dq->front = (dq->front + 1) & mask;
+    } else {
+        for (int i = position; i < dq->count - 1; i++) {
+            Tab *moved = dq->ring[(dq->front + i + 1) & mask];
+            dq->ring[(dq->front + i) & mask] = moved;
+            moved->slot = (dq->front + i) & mask;
+        }
+        dq->ring[dq->rear] = NULL;
+        dq->rear = (dq->rear - 1) & mask;
+    }
+    dq->count--;
+}
+
+// ========== FILENAME INDEX ==========
+
+// Canonical form of a filename for the index (absolute path when the file exists)
+static char* makeIndexKey(const char *filename) {
+    char resolved[PATH_MAX];
+    if (realpath(filename, resolved) != NULL) {
+        return strdup(resolved);
+    }
+    return strdup(filename);
+}
+
+// ALGORITHM: FNV-1a hash
+static unsigned int hashFilename(const char *key) {
+    unsigned int hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        hash = (hash ^ *p) * 16777619u;
+    }
+    return hash;
+}
+
+// Tab indexed under key, or NULL
+static Tab* indexFind(TabDeque *dq, const char *key) {
+    int mask = dq->indexCapacity - 1;
+    for (int i = hashFilename(key) & mask; dq->index[i] != NULL; i = (i + 1) & mask) {
+        if (dq->index[i] != INDEX_DELETED && strcmp(dq->index[i]->indexKey, key) == 0) {
+            return dq->index[i];
+        }
+    }
+    return NULL;
+}
+
+// Place a tab in the first free or deleted slot of its probe chain
+static void indexPlace(TabDeque *dq, Tab *tab) {
+    int mask = dq->indexCapacity - 1;
+    int i = hashFilename(tab->indexKey) & mask;
+    while (dq->index[i] != NULL && dq->index[i] != INDEX_DELETED) {
+        i = (i + 1) & mask;
+    }
+    if (dq->index[i] == NULL) {
+        dq->indexUsed++;
+    }
+    dq->index[i] = tab;
+}
+
+// Add a tab under its key (which must not be indexed yet)
+// The table is rebuilt when live + deleted slots pass 70%, growing if live tabs need it
+static void indexInsert(TabDeque *dq, Tab *tab) {
+    if ((dq->indexUsed + 1) * 10 > dq->indexCapacity * 7) {
+        Tab **old = dq->index;
+        int oldCapacity = dq->indexCapacity;
+        while ((dq->count + 1) * 10 > dq->indexCapacity * 5) {
+            dq->indexCapacity *= 2;
         }
+        dq->index = (Tab **)calloc(dq->indexCapacity, sizeof(Tab *));
+        dq->indexUsed = 0;
+        for (int i = 0; i < oldCapacity; i++) {
+            if (old[i] != NULL && old[i] != INDEX_DELETED) {
+                indexPlace(dq, old[i]);
+            }
+        }
+        free(old);
+    }
+    indexPlace(dq, tab);
+}
+
+// Remove a tab from the index
+static void indexRemove(TabDeque *dq, Tab *tab) {
+    int mask = dq->indexCapacity - 1;
+    for (int i = hashFilename(tab->indexKey) & mask; dq->index[i] != NULL; i = (i + 1) & mask) {
+        if (dq->index[i] == tab) {
+            dq->index[i] = INDEX_DELETED;
+            return;
+        }
+    }
+}
+
+// ========== LRU LIST ==========
+
+// Unlink a resident tab from the LRU list
+static void lruRemove(TabDeque *dq, Tab *tab) {
+    if (tab->lruPrev != NULL) {
+        tab->lruPrev->lruNext = tab->lruNext;
+    } else {
+        dq->lruHead = tab->lruNext;
+    }
+    if (tab->lruNext != NULL) {
+        tab->lruNext->lruPrev = tab->lruPrev;
+    } else {
+        dq->lruTail = tab->lruPrev;
+    }
+    tab->lruPrev = NULL;
+    tab->lruNext = NULL;
+}
+
+// Put a resident tab at the most recently used end
+static void lruPushFront(TabDeque *dq, Tab *tab) {
+    tab->lruPrev = NULL;
+    tab->lruNext = dq->lruHead;
+    if (dq->lruHead != NULL) {
+        dq->lruHead->lruPrev = tab;
+    } else {
+        dq->lruTail = tab;
     }
+    dq->lruHead = tab;
+}
+
+// ========== MATERIALIZATION ==========
+
+// Re-estimate the bytes held by a resident tab's editor
+// The dictionary is measured once per materialization; it dwarfs small documents
+static void updateResidentBytes(TabDeque *dq, Tab *tab) {
+    Editor *e = tab->editor;
+    long bytes = (long)sizeof(Editor) + (long)(e->length + 2) * (long)sizeof(Node)
+                 + e->clipboardSize + tab->dictionaryBytes;
+    dq->residentBytes += bytes - tab->residentBytes;
+    tab->residentBytes = bytes;
+}
+
+// Compress a flat snapshot in place
+static void compressSnapshot(TabSnapshot *snapshot) {
+    compressColdText(&(snapshot->cold), snapshot->text, snapshot->length);
+    free(snapshot->text);
+    snapshot->text = NULL;
+}
+
+// Free a resident tab's editor, keeping its text in a flat snapshot
+// (compressed if snapshot compression is on)
+// DATA STRUCTURE: Doubly Linked List -> array - one pass copies the text out
+static void evictTab(TabDeque *dq, Tab *tab) {
+    Editor *e = tab->editor;
     
-    if (tabIndex == -1) {
-        return -1;
+    tab->snapshot.text = getTextRange(e, 0, e->length);
+    tab->snapshot.length = e->length;
+    if (dq->compressSnapshots) {
+        compressSnapshot(&(tab->snapshot));
     }
+    tab->snapshot.cursorPos = e->cursorPos;
+    tab->snapshot.grammar = e->grammar;
+    tab->snapshot.modified = e->modified;
     
-    // Initialize editor for this tab
-    initEditor(&(dq->tabs[tabIndex].editor));
-    strcpy(dq->tabs[tabIndex].filename, filename);
-    dq->tabs[tabIndex].isActive = 1;
+    freeEditor(e);
+    free(e);
+    tab->editor = NULL;
+    tab->state = TAB_EVICTED;
     
-    dq->count++;
-    dq->currentTab = tabIndex;
+    lruRemove(dq, tab);
+    dq->residentBytes -= tab->residentBytes;
+    tab->residentBytes = 0;
+}
+
+// Evict least recently used tabs (never 'keep') until resident editors fit the budget
+// ALGORITHM: LRU - victims come off the tail of the list in O(1) each
+static void enforceMemoryBudget(TabDeque *dq, Tab *keep) {
+    Tab *victim = dq->lruTail;
+    while (dq->residentBytes > dq->memoryBudget && victim != NULL) {
+        Tab *previous = victim->lruPrev;
+        if (victim != keep) {
+            evictTab(dq, victim);
+        }
+        victim = previous;
+    }
+}
+
+// Highlight a tab's editor with the grammar for its file extension (the
+// default grammar when the extension is unknown)
+static void selectTabGrammar(Tab *tab, Editor *e) {
+    const Grammar *grammar = findGrammarForFile(tab->filename);
+    setEditorGrammar(e, (grammar != NULL) ? grammar : getDefaultGrammar());
+}
+
+// Create the editor of an unloaded or evicted tab
+// An evicted tab keeps the grammar it had; a new one gets its file's grammar
+static void materializeTab(TabDeque *dq, Tab *tab) {
+    Editor *e = (Editor *)malloc(sizeof(Editor));
+    initEditor(e);
+    
+    if (tab->state == TAB_EVICTED) {
+        int ownsText;
+        char *text = getSnapshotText(&(tab->snapshot), &ownsText);
+        setEditorText(e, text, (text != NULL) ? tab->snapshot.length : 0);
+        setEditorGrammar(e, tab->snapshot.grammar);
+        setCursorPosition(e, tab->snapshot.cursorPos);
+        e->modified = tab->snapshot.modified;
+        if (ownsText) {
+            free(text);
+        }
+        free(tab->snapshot.text);
+        tab->snapshot.text = NULL;
+        freeColdText(&(tab->snapshot.cold));
+    } else if (tab->loadOnUse) {
+        loadFile(e, tab->filename);
+    }
+    if (e->grammar == NULL) {
+        selectTabGrammar(tab, e);
+    }
+    
+    tab->editor = e;
+    tab->state = TAB_RESIDENT;
+    tab->residentBytes = 0;
+    tab->dictionaryBytes = getTrieMemoryUsage(&(e->dictionary));
+    lruPushFront(dq, tab);
+}
+
+// ========== TABS ==========
+
+// Create a tab handle; the editor is not created until the tab is used
+// The tab is indexed under its filename unless another tab already is
+static Tab* createTab(TabDeque *dq, const char *filename, int loadOnUse, const char *key) {
+    Tab *tab = (Tab *)malloc(sizeof(Tab));
+    strncpy(tab->filename, filename, sizeof(tab->filename) - 1);
+    tab->filename[sizeof(tab->filename) - 1] = '\0';
+    tab->editor = NULL;
+    tab->state = TAB_UNLOADED;
+    tab->loadOnUse = loadOnUse;
+    tab->snapshot.text = NULL;
+    initColdText(&(tab->snapshot.cold));
+    tab->snapshot.modified = 0;
+    tab->residentBytes = 0;
+    tab->dictionaryBytes = 0;
+    tab->lruPrev = NULL;
+    tab->lruNext = NULL;
     
-    return tabIndex;
+    tab->indexKey = NULL;
+    if (indexFind(dq, key) == NULL) {
+        tab->indexKey = strdup(key);
+        indexInsert(dq, tab);
+    }
+    return tab;
+}
+
+// Add a new empty tab named filename at the rear; returns its position
+int addTab(TabDeque *dq, const char *filename) {
+    char *key = makeIndexKey(filename);
+    Tab *tab = createTab(dq, filename, 0, key);
+    free(key);
+    pushBack(dq, tab);
+    dq->current = tab;
+    return dq->count - 1;
+}
+
+// Add a new empty tab named filename at the front; returns its position (0)
+int addTabFront(TabDeque *dq, const char *filename) {
+    char *key = makeIndexKey(filename);
+    Tab *tab = createTab(dq, filename, 0, key);
+    free(key);
+    pushFront(dq, tab);
+    dq->current = tab;
+    return 0;
+}
+
+// Open filename in a tab and make it current; returns its position
+// A file that is already open returns its existing tab. Otherwise a new tab is
+// added at the rear and the file is read when the tab is first used
+int openTab(TabDeque *dq, const char *filename) {
+    char *key = makeIndexKey(filename);
+    Tab *tab = indexFind(dq, key);
+    if (tab == NULL) {
+        tab = createTab(dq, filename, 1, key);
+        pushBack(dq, tab);
+    }
+    free(key);
+    dq->current = tab;
+    return tabPosition(dq, tab);
+}
+
+// Position of the tab open on filename, or -1 - O(1) expected
+int findTab(TabDeque *dq, const char *filename) {
+    char *key = makeIndexKey(filename);
+    Tab *tab = indexFind(dq, key);
+    free(key);
+    return (tab != NULL) ? tabPosition(dq, tab) : -1;
+}
+
+// Tab at a position, or NULL - O(1)
+Tab* getTab(TabDeque *dq, int tabIndex) {
+    if (tabIndex < 0 || tabIndex >= dq->count) {
+        return NULL;
+    }
+    return dq->ring[(dq->front + tabIndex) & (dq->capacity - 1)];
+}
+
+// Free a tab handle and everything it owns
+static void freeTab(TabDeque *dq, Tab *tab) {
+    if (tab->state == TAB_RESIDENT) {
+        lruRemove(dq, tab);
+        dq->residentBytes -= tab->residentBytes;
+        freeEditor(tab->editor);
+        free(tab->editor);
+    }
+    if (tab->indexKey != NULL) {
+        indexRemove(dq, tab);
+        free(tab->indexKey);
+    }
+    free(tab->snapshot.text);
+    freeColdText(&(tab->snapshot.cold));
+    free(tab);
 }
 
-// Remove a tab
+// Remove a tab - O(1) at either end
 int removeTab(TabDeque *dq, int tabIndex) {
-    if (tabIndex < 0 || tabIndex >= MAX_TABS || !dq->tabs[tabIndex].isActive) {
+    Tab *tab = getTab(dq, tabIndex);
+    if (tab == NULL) {
         return 0;
     }
     
-    // Free editor resources
-    freeEditor(&(dq->tabs[tabIndex].editor));
-    dq->tabs[tabIndex].isActive = 0;
-    strcpy(dq->tabs[tabIndex].filename, "");
+    removeAt(dq, tabIndex);
+    freeTab(dq, tab);
     
-    dq->count--;
-    
-    // If removed tab was current, switch to another tab
-    if (dq->currentTab == tabIndex) {
-        dq->currentTab = -1;
-        // Find first active tab
-        for (int i = 0; i < MAX_TABS; i++) {
-            if (dq->tabs[i].isActive) {
-                dq->currentTab = i;
-                break;
-            }
-        }
+    // If removed tab was current, its neighbour takes over
+    if (dq->current == tab) {
+        dq->current = getTab(dq, (tabIndex < dq->count) ? tabIndex : dq->count - 1);
     }
     
     return 1;
 }
 
-// Switch to a different tab
+// Switch to a different tab (restored from its snapshot if it was evicted)
 void switchTab(TabDeque *dq, int tabIndex) {
-    if (tabIndex >= 0 && tabIndex < MAX_TABS && dq->tabs[tabIndex].isActive) {
-        dq->currentTab = tabIndex;
+    Tab *tab = getTab(dq, tabIndex);
+    if (tab != NULL) {
+        dq->current = tab;
+        getTabEditor(dq, tabIndex);
     }
 }
 
-// Get current tab index
+// Get current tab index - O(1)
 int getCurrentTabIndex(TabDeque *dq) {
-    return dq->currentTab;
+    return (dq->current != NULL) ? tabPosition(dq, dq->current) : -1;
+}
+
+// Editor of a tab, materializing it on first use or after eviction
+// Marks the tab most recently used; other tabs may be evicted to stay within
+// the memory budget, so an Editor pointer from an earlier call can go stale
+Editor* getTabEditor(TabDeque *dq, int tabIndex) {
+    Tab *tab = getTab(dq, tabIndex);
+    if (tab == NULL) {
+        return NULL;
+    }
+    
+    if (tab->state != TAB_RESIDENT) {
+        materializeTab(dq, tab);
+    } else if (dq->lruHead != tab) {
+        lruRemove(dq, tab);
+        lruPushFront(dq, tab);
+    }
+    updateResidentBytes(dq, tab);   // Edits since the last call change its size
+    enforceMemoryBudget(dq, tab);
+    return tab->editor;
+}
+
+// Give an unloaded tab an editor built elsewhere (e.g. by a loader thread)
+// The tab becomes resident and most recently used; inactive tabs may be
+// evicted to stay within the budget, but never the current one
+// An editor without a grammar gets the one for the tab's file extension
+// Returns 1 if installed; 0 if the tab already had text, in which case e is
+// left to the caller
+int installTabEditor(TabDeque *dq, Tab *tab, Editor *e) {
+    if (tab->state != TAB_UNLOADED) {
+        return 0;
+    }
+    
+    if (e->grammar == NULL) {
+        selectTabGrammar(tab, e);
+    }
+    tab->editor = e;
+    tab->state = TAB_RESIDENT;
+    tab->residentBytes = 0;
+    tab->dictionaryBytes = getTrieMemoryUsage(&(e->dictionary));
+    lruPushFront(dq, tab);
+    updateResidentBytes(dq, tab);
+    enforceMemoryBudget(dq, dq->current);
+    return 1;
 }
 
 // Get current editor
 Editor* getCurrentEditor(TabDeque *dq) {
-    if (dq->currentTab >= 0 && dq->currentTab < MAX_TABS && dq->tabs[dq->currentTab].isActive) {
-        return &(dq->tabs[dq->currentTab].editor);
+    return getTabEditor(dq, getCurrentTabIndex(dq));
+}
+
+// Change the memory budget for resident editors (evicts at once if over it)
+void setTabMemoryBudget(TabDeque *dq, long bytes) {
+    dq->memoryBudget = bytes;
+    enforceMemoryBudget(dq, dq->current);
+}
+
+// Turn snapshot compression on or off
+// Turning it on compresses the snapshots of tabs already evicted; turning it
+// off leaves them compressed until they are used
+void setSnapshotCompression(TabDeque *dq, int enabled) {
+    dq->compressSnapshots = enabled;
+    if (!enabled) {
+        return;
+    }
+    for (int i = 0; i < dq->count; i++) {
+        Tab *tab = getTab(dq, i);
+        if (tab->state == TAB_EVICTED && tab->snapshot.text != NULL) {
+            compressSnapshot(&(tab->snapshot));
+        }
     }
-    return NULL;
+}
+
+// Text of an evicted tab's snapshot (snapshot->length bytes, not
+// null-terminated). A compressed snapshot is decoded into a new buffer and
+// *ownsText is set so the caller frees it; NULL if the data is corrupt
+// Safe to call from several threads at once on the same snapshot
+char* getSnapshotText(const TabSnapshot *snapshot, int *ownsText) {
+    *ownsText = 0;
+    if (snapshot->text != NULL || snapshot->length == 0) {
+        return snapshot->text;
+    }
+    *ownsText = 1;
+    return expandColdText(&(snapshot->cold));
 }
 
 // Display all tabs
 void displayTabs(TabDeque *dq) {
+    static const char *stateNames[] = {"not loaded", "in memory", "snapshot"};
+    long snapshotBytes = 0;
+    long snapshotTextBytes = 0;
     printf("\n--- Open Tabs ---\n");
-    for (int i = 0; i < MAX_TABS; i++) {
-        if (dq->tabs[i].isActive) {
-            if (i == dq->currentTab) {
-                printf("> [%d] %s (ACTIVE)\n", i, dq->tabs[i].filename);
-            } else {
-                printf("  [%d] %s\n", i, dq->tabs[i].filename);
-            }
+    for (int i = 0; i < dq->count; i++) {
+        Tab *tab = getTab(dq, i);
+        if (tab->state == TAB_EVICTED) {
+            snapshotTextBytes += tab->snapshot.length;
+            snapshotBytes += (tab->snapshot.text != NULL) ? tab->snapshot.length
+                                                           : tab->snapshot.cold.compressedBytes;
+        }
+        if (tab == dq->current) {
+            printf("> [%d] %s (ACTIVE, %s)\n", i, tab->filename, stateNames[tab->state]);
+        } else {
+            printf("  [%d] %s (%s)\n", i, tab->filename, stateNames[tab->state]);
         }
     }
+    printf("Resident editors: %ld KB of %ld KB budget\n", dq->residentBytes / 1024,
+           dq->memoryBudget / 1024);
+    printf("Snapshots: %ld KB holding %ld KB of text (compression %s)\n", snapshotBytes / 1024,
+           snapshotTextBytes / 1024, dq->compressSnapshots ? "on" : "off");
     printf("--- End of Tabs ---\n\n");
 }
 
 // Free all tabs
 void freeTabDeque(TabDeque *dq) {
-    for (int i = 0; i < MAX_TABS; i++) {
-        if (dq->tabs[i].isActive) {
-            freeEditor(&(dq->tabs[i].editor));
-        }
+    for (int i = 0; i < dq->count; i++) {
+        freeTab(dq, getTab(dq, i));
     }
+    free(dq->ring);
+    free(dq->index);
+    dq->ring = NULL;
+    dq->index = NULL;
+    dq->count = 0;
+    dq->current = NULL;
 }
-
@@ -2,37 +2,91 @@
 #define DEQUE_H
 
 #include "editor.h"
+#include "coldtext.h"
 
 // Deque (Double-Ended Queue) data structure for MULTIPLE FILE TABS
 // Allows insertion and deletion from both ends
 
-#define MAX_TABS 10
+#define TAB_INITIAL_CAPACITY 8                // Ring slots before the first growth
+#define TAB_MEMORY_BUDGET (8L * 1024 * 1024)  // Default bytes of materialized editors
 
-// Tab structure - each tab contains an editor instance
+// Tab storage states
+#define TAB_UNLOADED 0   // No editor yet: created on first use (from the file if loadOnUse)
+#define TAB_RESIDENT 1   // Editor in memory
+#define TAB_EVICTED  2   // Editor freed; text kept in a compact snapshot
+
+// What an evicted tab keeps: its text as a flat byte array (one byte per
+// character instead of one list node) plus enough state to restore the view
+// With snapshot compression on, the text is kept Huffman-coded in chunks
+// instead (text is NULL) and decoded again when the tab is used
+// Undo/redo history, clipboard and auto-save queue are dropped on eviction
 typedef struct {
-    Editor editor;        // Editor instance for this tab
+    char *text;          // Flat text, NULL when compressed
+    ColdText cold;       // Compressed text (no chunks unless compressed)
+    int length;
+    int cursorPos;
+    const Grammar *grammar;
+    int modified;        // Unsaved changes at eviction time
+} TabSnapshot;
+
+// Tab structure - a heap-allocated handle that owns an editor created lazily
+typedef struct Tab {
+    Editor *editor;       // Materialized editor (NULL unless TAB_RESIDENT)
     char filename[256];   // Filename associated with this tab
-    int isActive;         // 1 if tab is active, 0 otherwise
+    char *indexKey;       // Key in the filename index (canonical path), NULL if not indexed
+    int slot;             // Position in the ring buffer
+    int state;            // TAB_UNLOADED, TAB_RESIDENT or TAB_EVICTED
+    int loadOnUse;        // Unloaded tab reads its file when first materialized
+    TabSnapshot snapshot; // Text of an evicted tab
+    long residentBytes;   // Estimated footprint while resident
+    long dictionaryBytes; // Dictionary trie size, measured when materialized
+    struct Tab *lruPrev;  // Neighbours in the LRU list of resident tabs
+    struct Tab *lruNext;
 } Tab;
 
 // Deque structure for managing tabs
+// DATA STRUCTURE: Growable ring buffer of tab handles - O(1) push/pop at both
+// ends and O(1) access by position; a tab's position is (slot - front) mod capacity
+// DATA STRUCTURE: Hash table (open addressing, linear probing) from filename
+// to tab, so opening a file that is already open finds its tab in O(1)
+// DATA STRUCTURE: Intrusive doubly linked LRU list over the resident tabs,
+// so touching a tab and finding the eviction victim are O(1)
 typedef struct {
-    Tab tabs[MAX_TABS];   // Array of tabs
-    int front;            // Front index
-    int rear;             // Rear index
-    int count;            // Number of active tabs
-    int currentTab;       // Index of currently active tab
+    Tab **ring;           // Ring buffer of tab handles (capacity is a power of two)
+    int capacity;         // Slots in ring
+    int front;            // Slot of the first tab
+    int rear;             // Slot of the last tab (front - 1 when empty)
+    int count;            // Number of open tabs
+    Tab *current;         // Currently active tab (NULL when none)
+
+    Tab **index;          // Filename index slots: NULL, a tab, or a deleted marker
+    int indexCapacity;    // Slots in index (power of two)
+    int indexUsed;        // Slots holding a tab or a deleted marker
+
+    Tab *lruHead;         // Most recently used resident tab
+    Tab *lruTail;         // Least recently used resident tab
+    long residentBytes;   // Estimated bytes of all resident editors
+    long memoryBudget;    // Inactive tabs are evicted while residentBytes exceeds this
+    int compressSnapshots; // Evicted tabs keep their text compressed
 } TabDeque;
 
 // Function declarations
 void initTabDeque(TabDeque *dq);
 int addTab(TabDeque *dq, const char *filename);
+int addTabFront(TabDeque *dq, const char *filename);
+int openTab(TabDeque *dq, const char *filename);
+int findTab(TabDeque *dq, const char *filename);
+Tab* getTab(TabDeque *dq, int tabIndex);
 int removeTab(TabDeque *dq, int tabIndex);
 void switchTab(TabDeque *dq, int tabIndex);
 int getCurrentTabIndex(TabDeque *dq);
 Editor* getCurrentEditor(TabDeque *dq);
+Editor* getTabEditor(TabDeque *dq, int tabIndex);
+int installTabEditor(TabDeque *dq, Tab *tab, Editor *e);
+void setTabMemoryBudget(TabDeque *dq, long bytes);
+void setSnapshotCompression(TabDeque *dq, int enabled);
+char* getSnapshotText(const TabSnapshot *snapshot, int *ownsText);
 void displayTabs(TabDeque *dq);
 void freeTabDeque(TabDeque *dq);
 
 #endif
-
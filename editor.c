@@ -1,9 +1,17 @@
+#define _DEFAULT_SOURCE   // mkstemp, fchmod, fsync (POSIX, not declared under -std=c11)
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "editor.h"
+#include "analysis.h"
+#include "utf8.h"
+#include "snapfile.h"
 
 // ========== INITIALIZATION ==========
 
@@ -29,6 +37,8 @@ void initEditor(Editor *e) {
     e->length = 0;
     e->cursorRow = 0;
     e->cursorCol = 0;
+    e->cursorPos = 0;
+    e->modified = 0;
     
     // Initialize line structure (Linked List of strings)
     e->lineHead = NULL;
@@ -46,15 +56,32 @@ void initEditor(Editor *e) {
     
     // Initialize auto-save queue
     initQueue(&(e->autoSaveQueue));
-    strcpy(e->autoSaveFile, "autosave.txt");
+    strcpy(e->autoSaveFile, "autosave.snap");
     
     // Initialize spell checker (Trie)
     initTrie(&(e->dictionary));
     loadDictionary(&(e->dictionary), "dictionary.txt");
     e->spellCheckEnabled = 1;
+    initSpellCache(&(e->spellCache));
     
     // Initialize syntax highlighting
-    e->syntaxHighlightEnabled = 0;
+    e->grammar = NULL;
+    initLineCache(&(e->lineCache));
+}
+
+// Record that 'removed' characters at pos were replaced by 'inserted' characters
+// so cached analyses only revisit the touched region
+static void noteEdit(Editor *e, int pos, int inserted, int removed) {
+    e->modified = 1;
+    spellCacheNoteEdit(&(e->spellCache), pos, inserted, removed);
+    lineCacheNoteEdit(&(e->lineCache), pos, inserted, removed);
+}
+
+// Forget all cached analyses after the whole text was rebuilt
+static void noteReset(Editor *e) {
+    e->modified = 1;
+    spellCacheInvalidateAll(&(e->spellCache), e->length);
+    lineCacheInvalidateAll(&(e->lineCache), e->length);
 }
 
 // ========== BASIC FEATURES ==========
@@ -76,17 +103,74 @@ void insertChar(Editor *e, char c) {
     e->cursor = newNode;
     e->length++;
     e->cursorCol++;
+    e->cursorPos++;
+    noteEdit(e, e->cursorPos - 1, 1, 0);
     
     // Clear redo stack when new operation is performed
-    while (!isStackEmpty(&(e->redoStack))) {
-        pop(&(e->redoStack));
-    }
+    clearStack(&(e->redoStack));
     
     // Push to undo stack
     UndoOperation op;
     op.operation = 'i';
     op.data = c;
     op.position = e->length - 1;
+    op.text = NULL;
+    push(&(e->undoStack), op);
+}
+
+// Insert a run of characters at the cursor as one edit
+// DATA STRUCTURE: Doubly Linked List - the new nodes are chained first and spliced
+// in with one link update; caches are told once and one undo entry covers the run
+void insertText(Editor *e, const char *text, int length) {
+    if (length <= 0) {
+        return;
+    }
+    
+    // Chain the new nodes
+    Node *first = NULL;
+    Node *last = NULL;
+    for (int i = 0; i < length; i++) {
+        Node *newNode = (Node *)malloc(sizeof(Node));
+        newNode->data = text[i];
+        newNode->prev = last;
+        newNode->next = NULL;
+        if (last != NULL) {
+            last->next = newNode;
+        } else {
+            first = newNode;
+        }
+        last = newNode;
+        
+        if (text[i] == '\n') {
+            e->cursorRow++;
+            e->cursorCol = 0;
+        } else {
+            e->cursorCol++;
+        }
+    }
+    
+    // Splice the chain in after the cursor
+    first->prev = e->cursor;
+    last->next = e->cursor->next;
+    e->cursor->next->prev = last;
+    e->cursor->next = first;
+    
+    int start = e->cursorPos;
+    e->cursor = last;
+    e->length += length;
+    e->cursorPos += length;
+    noteEdit(e, start, length, 0);
+    
+    // Clear redo stack when new operation is performed
+    clearStack(&(e->redoStack));
+    
+    UndoOperation op;
+    op.operation = 'p';
+    op.data = '\0';
+    op.position = e->cursorPos;
+    op.count = length;
+    op.text = (char *)malloc(length);
+    memcpy(op.text, text, length);
     push(&(e->undoStack), op);
 }
 
@@ -103,15 +187,14 @@ void deleteChar(Editor *e) {
     char deletedChar = toDelete->data;
     
     // Clear redo stack
-    while (!isStackEmpty(&(e->redoStack))) {
-        pop(&(e->redoStack));
-    }
+    clearStack(&(e->redoStack));
     
     // Store in undo stack before deleting
     UndoOperation op;
     op.operation = 'd';
     op.data = deletedChar;
     op.position = e->length - 1;
+    op.text = NULL;
     push(&(e->undoStack), op);
     
     // Remove node from list
@@ -119,6 +202,7 @@ void deleteChar(Editor *e) {
     toDelete->next->prev = e->cursor;
     free(toDelete);
     e->length--;
+    noteEdit(e, e->cursorPos, 0, 1);
     
     if (e->cursorCol > 0) {
         e->cursorCol--;
@@ -130,6 +214,7 @@ void deleteChar(Editor *e) {
 void moveCursorLeft(Editor *e) {
     if (e->cursor != e->head) {
         e->cursor = e->cursor->prev;
+        e->cursorPos--;
         if (e->cursorCol > 0) {
             e->cursorCol--;
         }
@@ -141,6 +226,7 @@ void moveCursorLeft(Editor *e) {
 void moveCursorRight(Editor *e) {
     if (e->cursor->next != e->tail) {
         e->cursor = e->cursor->next;
+        e->cursorPos++;
         e->cursorCol++;
     }
 }
@@ -151,6 +237,7 @@ void moveCursorUp(Editor *e) {
     if (e->cursorRow > 0) {
         // Find previous newline
         Node *temp = e->cursor;
+        int pos = e->cursorPos;
         int newlinesFound = 0;
         
         while (temp != e->head && newlinesFound < 2) {
@@ -159,6 +246,7 @@ void moveCursorUp(Editor *e) {
             }
             if (newlinesFound < 2) {
                 temp = temp->prev;
+                pos--;
             }
         }
         
@@ -166,11 +254,14 @@ void moveCursorUp(Editor *e) {
             // Move to start of previous line
             while (temp != e->head && temp->data != '\n') {
                 temp = temp->prev;
+                pos--;
             }
             if (temp->data == '\n') {
                 temp = temp->next;
+                pos++;
             }
             e->cursor = temp;
+            e->cursorPos = pos;
             e->cursorRow--;
         }
     }
@@ -181,20 +272,87 @@ void moveCursorUp(Editor *e) {
 void moveCursorDown(Editor *e) {
     // Find next newline
     Node *temp = e->cursor;
+    int pos = e->cursorPos;
     
     while (temp->next != e->tail && temp->data != '\n') {
         temp = temp->next;
+        pos++;
     }
     
     if (temp->data == '\n' && temp->next != e->tail) {
         // Move to next line
         temp = temp->next;
         e->cursor = temp;
+        e->cursorPos = pos + 1;
         e->cursorRow++;
         e->cursorCol = 0;
     }
 }
 
+// Get the node just before offset pos (head for offset 0)
+// DATA STRUCTURE: Doubly Linked List - walks from the nearest of head, cursor and tail,
+// so lookups near the cursor cost O(distance from cursor)
+Node* getNodeBefore(Editor *e, int pos) {
+    if (pos <= 0) {
+        return e->head;
+    }
+    if (pos >= e->length) {
+        return e->tail->prev;
+    }
+    
+    int fromHead = pos;
+    int fromCursor = abs(pos - e->cursorPos);
+    int fromTail = e->length - pos;
+    
+    Node *current;
+    if (fromCursor <= fromHead && fromCursor <= fromTail) {
+        current = e->cursor;
+        for (int i = e->cursorPos; i < pos; i++) current = current->next;
+        for (int i = e->cursorPos; i > pos; i--) current = current->prev;
+    } else if (fromHead <= fromTail) {
+        current = e->head;
+        for (int i = 0; i < pos; i++) current = current->next;
+    } else {
+        current = e->tail->prev;
+        for (int i = e->length; i > pos; i--) current = current->prev;
+    }
+    return current;
+}
+
+// Copy the characters in [start, end) into a new null-terminated array
+char* getTextRange(Editor *e, int start, int end) {
+    char *text = (char *)malloc((end - start + 1) * sizeof(char));
+    Node *current = getNodeBefore(e, start)->next;
+    int i = 0;
+    
+    while (i < end - start && current != e->tail) {
+        text[i++] = current->data;
+        current = current->next;
+    }
+    text[i] = '\0';
+    
+    return text;
+}
+
+// Move the cursor to offset pos
+// DATA STRUCTURE: Doubly Linked List - walks from the nearest of head, cursor and tail;
+// the row and column come from the line cache's index
+void setCursorPosition(Editor *e, int pos) {
+    if (pos < 0) {
+        pos = 0;
+    }
+    if (pos > e->length) {
+        pos = e->length;
+    }
+    
+    e->cursor = getNodeBefore(e, pos);
+    e->cursorPos = pos;
+    
+    int lineStart = 0;
+    e->cursorRow = findLineAt(refreshLexedLines(e), pos, &lineStart);
+    e->cursorCol = pos - lineStart;
+}
+
 // Search for a word using array-based string matching
 // ALGORITHM: Linear search with string matching - O(n*m) where n=text length, m=word length
 void searchWord(Editor *e, const char *word) {
@@ -249,26 +407,14 @@ void searchWord(Editor *e, const char *word) {
     free(text);
 }
 
-// Word count using simple traversal
-// ALGORITHM: Linear traversal - O(n) where n=text length
+// Word count using the UTF-8 tokenizer
+// ALGORITHM: Linear traversal - O(n) where n=text length (parallel chunks for large documents)
 int getWordCount(Editor *e) {
-    int wordCount = 0;
-    int inWord = 0;
-    
-    Node *current = e->head->next;
-    while (current != e->tail) {
-        if (isalnum(current->data)) {
-            if (!inWord) {
-                wordCount++;
-                inWord = 1;
-            }
-        } else {
-            inWord = 0;
-        }
-        current = current->next;
-    }
-    
-    return wordCount;
+    char *text = getTextRange(e, 0, e->length);
+    AnalysisResult result;
+    analyzeText(text, e->length, 0, &(e->dictionary), ANALYSIS_WORDS, &result);
+    free(text);
+    return result.wordCount;
 }
 
 // Character count using simple traversal
@@ -460,6 +606,8 @@ void undo(Editor *e) {
             toDelete->next->prev = toDelete->prev;
             free(toDelete);
             e->length--;
+            e->cursorPos--;
+            noteEdit(e, e->cursorPos, 0, 1);
             if (e->cursorCol > 0) {
                 e->cursorCol--;
             }
@@ -469,6 +617,7 @@ void undo(Editor *e) {
                 toDelete->next->prev = e->cursor;
                 free(toDelete);
                 e->length--;
+                noteEdit(e, e->cursorPos, 0, 1);
         }
         printf("Undone: Insert operation\n");
     } else if (op.operation == 'd') {
@@ -482,7 +631,39 @@ void undo(Editor *e) {
         e->cursor = newNode;
         e->length++;
         e->cursorCol++;
+        e->cursorPos++;
+        noteEdit(e, e->cursorPos - 1, 1, 0);
         printf("Undone: Delete operation\n");
+    } else if (op.operation == 'p') {
+        // Undo bulk insert: unlink the whole run
+        int start = op.position - op.count;
+        if (start < 0 || op.position > e->length) {
+            // The run is no longer where it was recorded: neither it nor anything after it can be redone
+            clearStack(&(e->redoStack));
+            printf("Nothing to undo.\n");
+            return;
+        }
+        Node *before = getNodeBefore(e, start);
+        Node *current = before->next;
+        for (int i = 0; i < op.count; i++) {
+            Node *next = current->next;
+            free(current);
+            current = next;
+        }
+        before->next = current;
+        current->prev = before;
+        e->length -= op.count;
+        noteEdit(e, start, 0, op.count);
+        
+        // The cursor keeps its place in the remaining text (row and column recomputed)
+        int pos = e->cursorPos;
+        if (pos > op.position) {
+            pos -= op.count;
+        } else if (pos > start) {
+            pos = start;
+        }
+        setCursorPosition(e, pos);
+        printf("Undone: Paste operation (%d characters)\n", op.count);
     }
 }
 
@@ -496,25 +677,54 @@ void redo(Editor *e) {
     
     UndoOperation op = pop(&(e->redoStack));
     
+    if (op.operation == 'p') {
+        // Redo bulk insert: put the run back where it was. insertText records
+        // the undo entry and clears the redo stack, so the rest is kept aside
+        Stack pending = e->redoStack;
+        initStack(&(e->redoStack));
+        setCursorPosition(e, op.position - op.count);
+        insertText(e, op.text, op.count);
+        e->redoStack = pending;
+        free(op.text);
+        printf("Redone: Paste operation (%d characters)\n", op.count);
+        return;
+    }
+    
     // Push back to undo stack
     push(&(e->undoStack), op);
     
     if (op.operation == 'i') {
-        // Redo insert
+        // Redo insert (insertChar clears the redo stack, so the rest is kept aside)
+        Stack pending = e->redoStack;
+        initStack(&(e->redoStack));
         insertChar(e, op.data);
+        e->redoStack = pending;
         // Remove the duplicate undo entry
         if (!isStackEmpty(&(e->undoStack))) {
             pop(&(e->undoStack));
         }
         printf("Redone: Insert operation\n");
     } else if (op.operation == 'd') {
-        // Redo delete
-        if (e->cursor->next != e->tail) {
+        // Redo delete: undo left the cursor just after the restored character
+        if (e->cursor != e->head && e->cursor->data == op.data) {
+            Node *toDelete = e->cursor;
+            e->cursor = e->cursor->prev;
+            toDelete->prev->next = toDelete->next;
+            toDelete->next->prev = toDelete->prev;
+            free(toDelete);
+            e->length--;
+            e->cursorPos--;
+            noteEdit(e, e->cursorPos, 0, 1);
+            if (e->cursorCol > 0) {
+                e->cursorCol--;
+            }
+        } else if (e->cursor->next != e->tail) {
             Node *toDelete = e->cursor->next;
             e->cursor->next = toDelete->next;
             toDelete->next->prev = e->cursor;
             free(toDelete);
             e->length--;
+            noteEdit(e, e->cursorPos, 0, 1);
         }
         printf("Redone: Delete operation\n");
     }
@@ -565,6 +775,7 @@ void cutText(Editor *e, int start, int end) {
         current = current->next;
     }
     e->cursor = current->prev;
+    e->cursorPos = start;
     
     // Delete characters
     for (int i = 0; i < e->clipboardSize; i++) {
@@ -583,21 +794,8 @@ void paste(Editor *e) {
         return;
     }
     
-    // Insert each character from clipboard
-    for (int i = 0; i < e->clipboardSize; i++) {
-        insertChar(e, e->clipboard[i]);
-        // Remove undo entry for each insert (we'll add one at end)
-        if (!isStackEmpty(&(e->undoStack))) {
-            pop(&(e->undoStack));
-        }
-    }
-    
-    // Add single undo entry for paste operation
-    UndoOperation op;
-    op.operation = 'p';  // Paste operation
-    op.data = '\0';
-    op.position = e->length;
-    push(&(e->undoStack), op);
+    // Splice the clipboard in as one edit (one undo entry for the whole paste)
+    insertText(e, e->clipboard, e->clipboardSize);
     
     printf("Pasted %d characters.\n", e->clipboardSize);
 }
@@ -656,7 +854,9 @@ void findAndReplace(Editor *e, const char *find, const char *replace) {
     e->head->next = e->tail;
     e->tail->prev = e->head;
     e->cursor = e->head;
+    e->cursorPos = 0;
     e->length = 0;
+    noteReset(e);
     
     // Rebuild with replacements
     size_t textLen = strlen(text);
@@ -776,15 +976,13 @@ void autoSave(Editor *e) {
 }
 
 // Process auto-save queue
+// Each snapshot is written compressed and atomically (see snapfile.h)
 void processAutoSaveQueue(Editor *e) {
     int count = 0;
     while (!isQueueEmpty(&(e->autoSaveQueue))) {
         AutoSaveOperation op = dequeue(&(e->autoSaveQueue));
         
-        FILE *file = fopen(op.filename, "w");
-        if (file != NULL) {
-            fprintf(file, "%s", op.content);
-            fclose(file);
+        if (writeSnapshotFile(op.filename, op.content, op.contentLength) >= 0) {
             count++;
         }
         
@@ -798,115 +996,155 @@ void processAutoSaveQueue(Editor *e) {
     }
 }
 
-// Basic syntax highlighting using Hash table simulation
-// DATA STRUCTURE: Hash table (simulated with string comparison)
+// Replace the text with the last auto-save snapshot (left marked modified)
+// Blocks that fail their checksum are skipped, so whatever is intact comes
+// back. Without a snapshot, the plain-text auto-save of older builds is read
+void recoverAutoSave(Editor *e) {
+    int length = 0;
+    int badBlocks = 0;
+    const char *source = e->autoSaveFile;
+    char *text = readSnapshotFile(source, &length, &badBlocks);
+    if (text == NULL) {
+        if (access(source, F_OK) == 0) {
+            printf("Error: '%s' is not a valid snapshot\n", source);
+            return;
+        }
+        // No snapshot yet: fall back to the plain-text auto-save of older builds
+        source = LEGACY_AUTOSAVE_FILE;
+        text = readTextFile(source, &length);
+        if (text == NULL) {
+            printf("Error: Cannot open file '%s'\n", e->autoSaveFile);
+            return;
+        }
+    }
+    
+    loadText(e, text, length);
+    e->modified = 1;
+    free(text);
+    printf("Recovered %d characters from '%s'.\n", length, source);
+    if (badBlocks > 0) {
+        printf("Warning: %d damaged block(s) of %d characters each could not be recovered.\n",
+               badBlocks, SNAPSHOT_BLOCK_SIZE);
+    }
+}
+
+// Text source for the line cache
+static char* fetchEditorText(void *ctx, int start, int end) {
+    return getTextRange((Editor *)ctx, start, end);
+}
+
+// Select the grammar used for highlighting (NULL turns highlighting off)
+// Cached tokens belong to the previous grammar, so a change re-lexes everything
+void setEditorGrammar(Editor *e, const Grammar *grammar) {
+    if (grammar != e->grammar) {
+        e->grammar = grammar;
+        lineCacheInvalidateAll(&(e->lineCache), e->length);
+    }
+}
+
+// Basic syntax highlighting using a table-driven lexer
+// DATA STRUCTURE: DFA transition table + perfect hash for keywords, compiled
+// per language by the grammar registry
+// Tokens are cached per line; only lines touched by edits since the last call
+// (plus lines whose start state changed) are re-lexed
 void highlightSyntax(Editor *e) {
-    if (!e->syntaxHighlightEnabled) {
+    if (e->grammar == NULL) {
         printf("Syntax highlighting is disabled.\n");
         return;
     }
     
-    // Keywords for syntax highlighting (simulating hash table lookup)
-    const char *keywords[] = {
-        "if", "else", "for", "while", "int", "char", "void", "return",
-        "include", "define", "struct", "typedef", "const", "static"
-    };
-    int keywordCount = sizeof(keywords) / sizeof(keywords[0]);
+    LineCache *lc = &(e->lineCache);
+    refreshLineCache(lc, e->grammar, fetchEditorText, e);
+    char *text = getTextRange(e, 0, e->length);
     
-    // Convert text to array
-    char *text = (char *)malloc((e->length + 1) * sizeof(char));
-    Node *current = e->head->next;
+    printf("\n--- Syntax Highlighted Text (%s) ---\n", e->grammar->name);
     int i = 0;
-    
-    while (current != e->tail) {
-        text[i++] = current->data;
-        current = current->next;
-    }
-    text[i] = '\0';
-    
-    printf("\n--- Syntax Highlighted Text ---\n");
-    // Simple highlighting: just identify keywords
-    int highlighted = 0;
-    size_t textLen = strlen(text);
-    for (i = 0; i < (int)textLen; i++) {
-        // Check if current position starts a keyword
-        int isKeyword = 0;
-        for (int k = 0; k < keywordCount; k++) {
-            int len = (int)strlen(keywords[k]);
-            if (i + len <= (int)textLen) {
-                int match = 1;
-                for (int j = 0; j < len; j++) {
-                    if (tolower(text[i + j]) != tolower(keywords[k][j])) {
-                        match = 0;
-                        break;
-                    }
-                }
-                if (match && (i == 0 || !isalnum(text[i-1])) && 
-                    (i + len >= (int)textLen || !isalnum(text[i + len]))) {
-                    printf("[KEYWORD:%s]", keywords[k]);
-                    i += len - 1;
-                    isKeyword = 1;
-                    highlighted++;
-                    break;
-                }
+    int lineStart = 0;
+    int keywordCount = 0;
+    int lines = getCachedLineCount(lc);
+    for (int n = 0; n < lines; n++) {
+        LineEntry *line = getCachedLine(lc, n);
+        for (int k = 0; k < line->tokenCount; k++) {
+            Token tok = line->tokens[k];
+            if (tok.type != TOKEN_KEYWORD) {
+                continue;
             }
+            int start = lineStart + tok.start;
+            fwrite(text + i, 1, start - i, stdout);
+            printf("[KEYWORD:");
+            for (int j = 0; j < tok.length; j++) {
+                putchar(tolower((unsigned char)text[start + j]));
+            }
+            printf("]");
+            i = start + tok.length;
+            keywordCount++;
         }
-        if (!isKeyword) {
-            printf("%c", text[i]);
-        }
+        lineStart += line->length;
     }
+    fwrite(text + i, 1, e->length - i, stdout);
     printf("\n--- End of Highlighted Text ---\n");
-    printf("Highlighted %d keyword(s).\n\n", highlighted);
+    printf("Highlighted %d keyword(s).\n\n", keywordCount);
     
     free(text);
 }
 
+// Re-check only the words touched by edits since the last check
+// ALGORITHM: Each dirty range is widened to word boundaries and re-tokenized,
+// so a single keystroke costs O(word length) instead of O(n)
+void refreshSpellCheck(Editor *e) {
+    SpellCache *sc = &(e->spellCache);
+    
+    while (spellCacheHasDirty(sc)) {
+        DirtyRange r = spellCachePopDirty(sc);
+        
+        // Widen the range to the start of the word it begins in
+        Node *node = getNodeBefore(e, r.start);
+        int rangeStart = r.start;
+        while (node != e->head && isWordByte((unsigned char)node->data)) {
+            node = node->prev;
+            rangeStart--;
+        }
+        
+        // ... and to the end of the word it finishes in
+        Node *last = getNodeBefore(e, r.end);
+        int rangeEnd = r.end;
+        while (last->next != e->tail && isWordByte((unsigned char)last->next->data)) {
+            last = last->next;
+            rangeEnd++;
+        }
+        
+        // Check the widened text (in parallel chunks when it is large)
+        char *text = getTextRange(e, rangeStart, rangeEnd);
+        AnalysisResult result;
+        analyzeText(text, rangeEnd - rangeStart, rangeStart, &(e->dictionary),
+                    ANALYSIS_SPELLING, &result);
+        
+        // The cache takes over the misspelled words
+        spellCacheReplaceRange(sc, rangeStart, rangeEnd, result.misspelled, result.misspelledCount);
+        result.misspelledCount = 0;
+        freeAnalysisResult(&result);
+        free(text);
+    }
+}
+
 // Spell checker using Trie
 // DATA STRUCTURE: Trie (Prefix Tree) - O(m) search time where m=word length
+// Results come from the incremental spell cache; only dirty regions are re-checked
 void checkSpelling(Editor *e) {
     if (!e->spellCheckEnabled) {
         printf("Spell checking is disabled.\n");
         return;
     }
     
-    // Extract words from text
-    char *text = (char *)malloc((e->length + 1) * sizeof(char));
-    Node *current = e->head->next;
-    int i = 0;
+    refreshSpellCheck(e);
     
-    while (current != e->tail) {
-        text[i++] = current->data;
-        current = current->next;
-    }
-    text[i] = '\0';
-    
-    // Extract and check each word
-    char word[100];
-    int wordStart = -1;
-    int misspelledCount = 0;
+    SpellCache *sc = &(e->spellCache);
+    int misspelledCount = getMisspellingCount(sc);
     
     printf("\n--- Spell Check Results ---\n");
-    for (i = 0; i <= e->length; i++) {
-        if (i < e->length && isalnum(text[i])) {
-            if (wordStart == -1) {
-                wordStart = i;
-            }
-        } else {
-            if (wordStart != -1) {
-                // Extract word
-                int wordLen = i - wordStart;
-                strncpy(word, text + wordStart, wordLen);
-                word[wordLen] = '\0';
-                
-                // Check spelling using Trie
-                if (!searchWordInTrie(&(e->dictionary), word)) {
-                    printf("Misspelled: '%s' at position %d\n", word, wordStart);
-                    misspelledCount++;
-                }
-                
-                wordStart = -1;
-            }
-        }
+    for (int i = 0; i < misspelledCount; i++) {
+        MisspelledWord w = getMisspellingAt(sc, i);
+        printf("Misspelled: '%s' at position %d\n", w.word, w.start);
     }
     
     if (misspelledCount == 0) {
@@ -915,54 +1153,229 @@ void checkSpelling(Editor *e) {
         printf("Found %d misspelled word(s).\n", misspelledCount);
     }
     printf("--- End of Spell Check ---\n\n");
+}
+
+// Add a user word to the dictionary
+// DATA STRUCTURE: Trie - the insert publishes a new version atomically, so
+// spell checks running on other threads keep reading without blocking
+void addWordToDictionary(Editor *e, const char *word) {
+    if (word == NULL || strlen(word) == 0) {
+        printf("Invalid word.\n");
+        return;
+    }
     
-    free(text);
+    insertWord(&(e->dictionary), word);
+    
+    // Cached misspellings of this word are stale: queue just those spans
+    SpellCache *sc = &(e->spellCache);
+    for (int i = 0; i < getMisspellingCount(sc); i++) {
+        MisspelledWord w = getMisspellingAt(sc, i);
+        if (searchWordInTrie(&(e->dictionary), w.word)) {
+            spellCacheMarkDirty(sc, w.start, w.start + w.length);
+        }
+    }
+    
+    printf("Added '%s' to the dictionary.\n", word);
+}
+
+// Bring the line cache up to date; brackets need a grammar to tell code from
+// strings and comments. Tabs set the grammar of their file's extension; an
+// editor without one (not in a tab) is lexed with the default grammar
+LineCache* refreshLexedLines(Editor *e) {
+    if (e->grammar == NULL) {
+        setEditorGrammar(e, getDefaultGrammar());
+    }
+    refreshLineCache(&(e->lineCache), e->grammar, fetchEditorText, e);
+    return &(e->lineCache);
+}
+
+// Brackets of one cached line (code only), as document offsets and characters
+// Returns the count; the arrays are malloc'd
+static int getLineBrackets(Editor *e, int index, int **offsets, char **chars) {
+    LineCache *lc = &(e->lineCache);
+    LineEntry *line = getCachedLine(lc, index);
+    int lineStart = getLineStart(lc, index);
+    
+    *offsets = (int *)malloc((line->tokenCount + 1) * sizeof(int));
+    *chars = (char *)malloc(line->tokenCount + 1);
+    int count = 0;
+    for (int k = 0; k < line->tokenCount; k++) {
+        Token tok = line->tokens[k];
+        if (tok.type == TOKEN_PUNCTUATION && tok.length == 1 && bracketDelta(tok.first) != 0) {
+            (*offsets)[count] = lineStart + tok.start;
+            (*chars)[count] = tok.first;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Opening bracket for a closing one
+static char openingBracket(char c) {
+    return (c == ')') ? '(' : (c == ']') ? '[' : '{';
 }
 
-// Bracket matching using Stack
-// DATA STRUCTURE: Stack - LIFO for matching opening and clo
+// Offset of the bracket of line 'index' reached when the running balance
+// first (forward) or last (backward) is at most target; -1 if none
+// Backward returns the bracket right after that point; bracket receives its character
+static int scanLineForBalance(Editor *e, int index, int target, int forward, int limit,
+                              char *bracket) {
+    int *offsets;
+    char *chars;
+    int count = getLineBrackets(e, index, &offsets, &chars);
+    int balance = getBracketBalanceBefore(&(e->lineCache), index);
+    int found = -1;
+    
+    if (forward) {
+        for (int k = 0; k < count && found < 0; k++) {
+            balance += bracketDelta((unsigned char)chars[k]);
+            if (offsets[k] > limit && balance <= target) {
+                found = offsets[k];
+                *bracket = chars[k];
+            }
+        }
+    } else {
+        // Balance before each bracket; the last point at or below target wins
+        for (int k = 0; k < count && offsets[k] < limit; k++) {
+            if (balance <= target) {
+                found = offsets[k];
+                *bracket = chars[k];
+            }
+            balance += bracketDelta((unsigned char)chars[k]);
+        }
+    }
+    
+    free(offsets);
+    free(chars);
+    return found;
+}
+
+// Find the bracket matching the one at offset pos
+// Returns its offset, or -1 if pos is not a code bracket, has no partner, or
+// the partner is of a different kind
+// ALGORITHM: Balance search on the line tree - O(log n) plus two line scans
+int findMatchingBracket(Editor *e, int pos) {
+    LineCache *lc = refreshLexedLines(e);
+    int index = findLineAt(lc, pos, NULL);
+    
+    // Locate the bracket and the balance around it
+    int *offsets;
+    char *chars;
+    int count = getLineBrackets(e, index, &offsets, &chars);
+    int balance = getBracketBalanceBefore(lc, index);
+    int k = 0;
+    while (k < count && offsets[k] != pos) {
+        balance += bracketDelta((unsigned char)chars[k]);
+        k++;
+    }
+    if (k == count) {
+        free(offsets);
+        free(chars);
+        return -1;
+    }
+    char c = chars[k];
+    free(offsets);
+    free(chars);
+    
+    int partner;
+    char other = 0;
+    if (bracketDelta((unsigned char)c) > 0) {
+        // Closing partner: first point after pos where the balance returns to 'balance'
+        partner = scanLineForBalance(e, index, balance, 1, pos, &other);
+        if (partner < 0) {
+            int line = findBalanceLineForward(lc, index + 1, balance);
+            partner = (line < 0) ? -1 : scanLineForBalance(e, line, balance, 1, pos, &other);
+        }
+    } else {
+        // Opening partner: last point before pos where the balance was 'balance - 1'
+        partner = scanLineForBalance(e, index, balance - 1, 0, pos, &other);
+        if (partner < 0) {
+            int line = findBalanceLineBackward(lc, index, balance - 1);
+            partner = (line < 0) ? -1 : scanLineForBalance(e, line, balance - 1, 0, pos, &other);
+        }
+    }
+    if (partner < 0) {
+        return -1;
+    }
+    
+    char open = (bracketDelta((unsigned char)c) > 0) ? c : other;
+    char close = (bracketDelta((unsigned char)c) > 0) ? other : c;
+    return (openingBracket(close) == open) ? partner : -1;
+}
+
+// First bracket that breaks the balance: the first closing bracket with no
+// opening partner, else the first opening bracket never closed; -1 if balanced
+// (bracket kinds are not compared; checkBracketMatching reports mismatches)
+// ALGORITHM: Balance search on the line tree - O(log n) plus one line scan
+int findFirstUnbalancedBracket(Editor *e) {
+    LineCache *lc = refreshLexedLines(e);
+    int lines = getCachedLineCount(lc);
+    char bracket;
+    
+    int line = findBalanceLineForward(lc, 0, -1);
+    if (line >= 0) {
+        return scanLineForBalance(e, line, -1, 1, -1, &bracket);
+    }
+    if (getBracketBalanceBefore(lc, lines) == 0) {
+        return -1;
+    }
+    // Opening bracket after the last point where the balance is zero
+    line = findBalanceLineBackward(lc, lines, 0);
+    return scanLineForBalance(e, line, 0, 0, e->length, &bracket);
+}
+
+// Bracket matching over the lexed tokens (brackets in strings and comments are
+// ignored) with a growable stack, so nesting depth is unlimited
+// DATA STRUCTURE: Stack - LIFO for matching opening and closing brackets
 int checkBracketMatching(Editor *e) {
-    Stack bracketStack;
-    initStack(&bracketStack);
+    LineCache *lc = refreshLexedLines(e);
     
-    Node *current = e->head->next;
+    char *stack = NULL;
+    int depth = 0;
+    int capacity = 0;
     int errors = 0;
-    
-    while (current != e->tail) {
-        char c = current->data;
-        
-        // Push opening brackets
-        if (c == '(' || c == '[' || c == '{') {
-            UndoOperation op;
-            op.operation = c;
-            op.data = c;
-            op.position = 0;
-            push(&bracketStack, op);
-        }
-        // Check closing brackets
-        else if (c == ')' || c == ']' || c == '}') {
-            if (isStackEmpty(&bracketStack)) {
-                printf("Error: Unmatched closing bracket '%c'\n", c);
-                errors++;
-            } else {
-                UndoOperation op = pop(&bracketStack);
-                char expected = (c == ')') ? '(' : (c == ']') ? '[' : '{';
-                if (op.operation != expected) {
-                    printf("Error: Mismatched brackets. Expected '%c', found '%c'\n", expected, op.operation);
+    int lines = getCachedLineCount(lc);
+    
+    for (int n = 0; n < lines; n++) {
+        LineEntry *line = getCachedLine(lc, n);
+        for (int k = 0; k < line->tokenCount; k++) {
+            Token tok = line->tokens[k];
+            if (tok.type != TOKEN_PUNCTUATION || tok.length != 1) {
+                continue;
+            }
+            char c = tok.first;
+            
+            // Push opening brackets
+            if (bracketDelta((unsigned char)c) > 0) {
+                if (depth == capacity) {
+                    capacity = (capacity == 0) ? 64 : capacity * 2;
+                    stack = (char *)realloc(stack, capacity);
+                }
+                stack[depth++] = c;
+            }
+            // Check closing brackets
+            else if (bracketDelta((unsigned char)c) < 0) {
+                if (depth == 0) {
+                    printf("Error: Unmatched closing bracket '%c'\n", c);
                     errors++;
+                } else {
+                    char open = stack[--depth];
+                    char expected = openingBracket(c);
+                    if (open != expected) {
+                        printf("Error: Mismatched brackets. Expected '%c', found '%c'\n", expected, open);
+                        errors++;
+                    }
                 }
             }
         }
-        
-        current = current->next;
     }
     
     // Check for unmatched opening brackets
-    while (!isStackEmpty(&bracketStack)) {
-        UndoOperation op = pop(&bracketStack);
-        printf("Error: Unmatched opening bracket '%c'\n", op.operation);
+    while (depth > 0) {
+        printf("Error: Unmatched opening bracket '%c'\n", stack[--depth]);
         errors++;
     }
+    free(stack);
     
     if (errors == 0) {
         printf("All brackets are properly matched!\n");
@@ -998,14 +1411,9 @@ void getSearchSuggestions(Editor *e, const char *prefix) {
 
 // ========== FILE OPERATIONS ==========
 
-// Load text from file
-void loadFile(Editor *e, const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        printf("Error: Cannot open file '%s'\n", filename);
-        return;
-    }
-    
+// Replace the whole text (no undo entry); the cursor moves to the start
+// DATA STRUCTURE: Doubly Linked List - old nodes are freed and the new ones chained in one pass
+void setEditorText(Editor *e, const char *text, int length) {
     // Clear existing content
     Node *current = e->head->next;
     while (current != e->tail) {
@@ -1013,46 +1421,184 @@ void loadFile(Editor *e, const char *filename) {
         current = current->next;
         free(temp);
     }
-    e->head->next = e->tail;
-    e->tail->prev = e->head;
-    e->cursor = e->head;
-    e->length = 0;
-    e->lineCount = 0;
     
-    // Read file character by character
-    int c;
-    while ((c = fgetc(file)) != EOF) {
-        insertChar(e, (char)c);
-        // Remove undo entries for file loading
-        if (!isStackEmpty(&(e->undoStack))) {
-            pop(&(e->undoStack));
-        }
-        if (c == '\n') {
+    Node *last = e->head;
+    e->lineCount = 0;
+    for (int i = 0; i < length; i++) {
+        Node *newNode = (Node *)malloc(sizeof(Node));
+        newNode->data = text[i];
+        newNode->prev = last;
+        last->next = newNode;
+        last = newNode;
+        if (text[i] == '\n') {
             e->lineCount++;
         }
     }
+    last->next = e->tail;
+    e->tail->prev = last;
     
-    fclose(file);
-    printf("File '%s' loaded successfully.\n", filename);
+    e->cursor = e->head;
+    e->cursorPos = 0;
+    e->cursorRow = 0;
+    e->cursorCol = 0;
+    e->length = length;
+    clearStack(&(e->redoStack));
+    noteReset(e);
 }
 
-// Save text to file
-void saveFile(Editor *e, const char *filename) {
-    FILE *file = fopen(filename, "w");
+// Replace the whole text with freshly loaded file contents: the cursor ends
+// up after the text and the editor counts as unmodified
+void loadText(Editor *e, const char *text, int length) {
+    setEditorText(e, text, length);
+    
+    e->cursor = e->tail->prev;
+    e->cursorPos = e->length;
+    e->cursorRow = e->lineCount;
+    for (Node *n = e->cursor; n != e->head && n->data != '\n'; n = n->prev) {
+        e->cursorCol++;
+    }
+    e->modified = 0;
+}
+    
+// Read a whole file into a new array (caller frees); NULL if it cannot be opened
+// Touches no editor state, so it is safe to call from worker threads
+char* readTextFile(const char *filename, int *length) {
+    FILE *file = fopen(filename, "rb");
     if (file == NULL) {
-        printf("Error: Cannot create file '%s'\n", filename);
-        return;
+        return NULL;
+    }
+    
+    int capacity = 4096;
+    int used = 0;
+    char *text = (char *)malloc(capacity);
+    size_t n;
+    while ((n = fread(text + used, 1, capacity - used, file)) > 0) {
+        used += (int)n;
+        if (used == capacity) {
+            capacity *= 2;
+            text = (char *)realloc(text, capacity);
+        }
     }
+    fclose(file);
     
-    // Write all characters to file
-    Node *current = e->head->next;
-    while (current != e->tail) {
-        fputc(current->data, file);
-        current = current->next;
+    *length = used;
+    return text;
+}
+    
+// Create the temporary file an atomic write goes to, next to filename and with
+// its permissions; returns the descriptor (name in tempName) or -1
+static int beginAtomicWrite(const char *filename, char *tempName, int tempSize) {
+    snprintf(tempName, tempSize, "%s.XXXXXX", filename);
+    int fd = mkstemp(tempName);
+    if (fd < 0) {
+        return -1;
     }
     
-    fclose(file);
+    // Keep the permissions of the file being replaced
+    struct stat info;
+    fchmod(fd, (stat(filename, &info) == 0) ? (info.st_mode & 07777) : 0644);
+    return fd;
+}
+
+// Write all length bytes to fd; 0 on success, -1 on failure
+static int writeAll(int fd, const char *data, int length) {
+    int written = 0;
+    while (written < length) {
+        ssize_t n = write(fd, data + written, length - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        written += (int)n;
+    }
+    return 0;
+}
+
+// Flush the temporary file and rename it over filename, or drop it if the
+// write failed (status -1); returns 0 if filename now holds the new text
+static int finishAtomicWrite(int fd, const char *tempName, const char *filename, int status) {
+    if (status != 0 || fsync(fd) != 0) {
+        close(fd);
+        unlink(tempName);
+        return -1;
+    }
+    if (close(fd) != 0 || rename(tempName, filename) != 0) {
+        unlink(tempName);
+        return -1;
+    }
+    return 0;
+}
+
+// Write text to filename atomically: the data goes to a temporary file in the
+// same directory, is flushed to disk, and then renamed over the target, so a
+// crash leaves either the old file or the new one, never a partial write
+// Returns 0 on success, -1 on failure (the target is untouched)
+// Touches no editor state, so it is safe to call from worker threads
+int writeTextFile(const char *filename, const char *text, int length) {
+    char tempName[300];
+    int fd = beginAtomicWrite(filename, tempName, sizeof(tempName));
+    if (fd < 0) {
+        return -1;
+    }
+    return finishAtomicWrite(fd, tempName, filename, writeAll(fd, text, length));
+}
+
+// Atomic write like writeTextFile, of length bytes that read supplies in
+// pieces of up to chunkSize through one buffer, so the whole text never
+// has to be in memory at once
+int writeTextStream(const char *filename, TextReadFn read, void *ctx, int length, int chunkSize) {
+    char tempName[300];
+    int fd = beginAtomicWrite(filename, tempName, sizeof(tempName));
+    if (fd < 0) {
+        return -1;
+    }
+    
+    char *buffer = (char *)malloc(chunkSize);
+    int status = 0;
+    for (int written = 0; written < length && status == 0; ) {
+        int wanted = (length - written < chunkSize) ? length - written : chunkSize;
+        int n = read(ctx, written, wanted, buffer);
+        if (n <= 0) {
+            status = -1;
+            break;
+        }
+        status = writeAll(fd, buffer, n);
+        written += n;
+    }
+    free(buffer);
+    return finishAtomicWrite(fd, tempName, filename, status);
+}
+    
+// Load text from file
+void loadFile(Editor *e, const char *filename) {
+    int length = 0;
+    char *text = readTextFile(filename, &length);
+    if (text == NULL) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return;
+    }
+    
+    // Read the whole file, then build the list in one pass
+    loadText(e, text, length);
+    free(text);
+    printf("File '%s' loaded successfully.\n", filename);
+}
+
+// Save text to file (atomically, see writeTextFile); returns writeTextFile's status
+int saveFile(Editor *e, const char *filename) {
+    char *text = getTextRange(e, 0, e->length);
+    int status = writeTextFile(filename, text, e->length);
+    free(text);
+    
+    if (status != 0) {
+        printf("Error: Cannot create file '%s'\n", filename);
+        return -1;
+    }
+    e->modified = 0;
     printf("File '%s' saved successfully.\n", filename);
+    return 0;
 }
 
 // Free all memory
@@ -1074,8 +1620,14 @@ void freeEditor(Editor *e) {
         free(e->clipboard);
     }
     
-    // Free trie
+    // Free undo history (bulk inserts keep a copy of their text)
+    clearStack(&(e->undoStack));
+    clearStack(&(e->redoStack));
+    
+    // Free trie and spell cache
     freeTrie(&(e->dictionary));
+    freeSpellCache(&(e->spellCache));
+    freeLineCache(&(e->lineCache));
     
     // Process and free auto-save queue
     processAutoSaveQueue(e);
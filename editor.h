@@ -4,6 +4,8 @@
 #include "stack.h"
 #include "queue.h"
 #include "trie.h"
+#include "spellcache.h"
+#include "linecache.h"
 
 // Doubly Linked List Node for storing characters
 // Each node stores one character and pointers to previous and next nodes
@@ -40,6 +42,8 @@ typedef struct {
     int length;          // Total number of characters
     int cursorRow;       // Cursor row (line number)
     int cursorCol;       // Cursor column (position in line)
+    int cursorPos;       // Cursor offset (number of characters before cursor)
+    int modified;        // Text changed since it was last loaded or saved
     
     // Undo/Redo using two Stacks
     Stack undoStack;     // Stack for undo operations
@@ -56,9 +60,11 @@ typedef struct {
     // Spell checker and suggestions
     Trie dictionary;     // Trie for spell checking
     int spellCheckEnabled; // Flag for spell check
+    SpellCache spellCache; // Cached misspellings + dirty ranges from edits
     
-    // Syntax highlighting (using Hash table simulation)
-    int syntaxHighlightEnabled; // Flag for syntax highlighting
+    // Syntax highlighting (table-driven lexer)
+    const Grammar *grammar; // Shared compiled grammar, NULL when highlighting is off
+    LineCache lineCache; // Per-line lexer states and tokens, re-lexed incrementally
 } Editor;
 
 // Function declarations
@@ -71,6 +77,9 @@ void initEditor(Editor *e);
 // Insert character at cursor position (Doubly Linked List insertion)
 void insertChar(Editor *e, char c);
 
+// Insert a run of characters at the cursor as one edit (one undo entry)
+void insertText(Editor *e, const char *text, int length);
+
 // Delete character at cursor position (Doubly Linked List deletion)
 void deleteChar(Editor *e);
 
@@ -95,6 +104,15 @@ int getWordCount(Editor *e);
 // Character count using simple traversal
 int getCharCount(Editor *e);
 
+// Get the node just before offset pos (walks from the nearest of head, cursor, tail)
+Node* getNodeBefore(Editor *e, int pos);
+
+// Copy the characters in [start, end) into a new null-terminated array (caller frees)
+char* getTextRange(Editor *e, int start, int end);
+
+// Move the cursor to offset pos
+void setCursorPosition(Editor *e, int pos);
+
 // Display text with cursor
 void displayText(Editor *e);
 
@@ -136,23 +154,65 @@ void autoSave(Editor *e);
 // Process auto-save queue
 void processAutoSaveQueue(Editor *e);
 
-// Basic syntax highlighting using Hash table simulation
+// Restore the text from the last auto-save snapshot
+void recoverAutoSave(Editor *e);
+
+// Select the highlighting grammar (NULL turns highlighting off)
+void setEditorGrammar(Editor *e, const Grammar *grammar);
+
+// Syntax highlighting with the editor's grammar
 void highlightSyntax(Editor *e);
 
+// Bring the per-line cache (line index, tokens, bracket sums) up to date
+LineCache* refreshLexedLines(Editor *e);
+
 // Spell checker using Trie
 void checkSpelling(Editor *e);
 
-// Bracket matching using Stack
+// Re-check only the words touched by edits since the last check
+void refreshSpellCheck(Editor *e);
+
+// Bracket queries read the code tokens of the editor's grammar, so brackets
+// in strings and comments (as that language writes them) are ignored
+
+// Bracket matching over lexed code (strings and comments ignored)
 int checkBracketMatching(Editor *e);
 
+// Offset of the bracket matching the one at pos, or -1
+int findMatchingBracket(Editor *e, int pos);
+
+// Offset of the first bracket that breaks the balance, or -1
+int findFirstUnbalancedBracket(Editor *e);
+
+// Add a user word to the dictionary (safe while background checks are reading it)
+void addWordToDictionary(Editor *e, const char *word);
+
 // Search suggestions using Trie
 void getSearchSuggestions(Editor *e, const char *prefix);
 
+// Replace the whole text without an undo entry (cursor moves to the start)
+void setEditorText(Editor *e, const char *text, int length);
+
+// Replace the whole text with loaded file contents (cursor at the end, unmodified)
+void loadText(Editor *e, const char *text, int length);
+
+// Read a whole file into a new array (caller frees), NULL if it cannot be opened
+char* readTextFile(const char *filename, int *length);
+
+// Write a file atomically (temporary file, fsync, rename); 0 on success, -1 on failure
+int writeTextFile(const char *filename, const char *text, int length);
+
+// Supplies up to length bytes of a text from offset start into out; returns the count, -1 on error
+typedef int (*TextReadFn)(void *ctx, int start, int length, char *out);
+
+// Write a file atomically from a text read piece by piece; 0 on success, -1 on failure
+int writeTextStream(const char *filename, TextReadFn read, void *ctx, int length, int chunkSize);
+
 // Load text from file
 void loadFile(Editor *e, const char *filename);
 
-// Save text to file
-void saveFile(Editor *e, const char *filename);
+// Save text to file; 0 on success, -1 on failure
+int saveFile(Editor *e, const char *filename);
 
 // Free all memory
 void freeEditor(Editor *e);
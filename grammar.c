@@ -0,0 +1,625 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "grammar.h"
+#include "lexer.h"
+#include "utf8.h"
+
+// Built-in languages; the first one is the default for unknown extensions
+static const GrammarDef builtinGrammars[] = {
+    {
+        "c", ".c .h .cpp .hpp .cc",
+        "if else for while do switch case default break continue return goto "
+        "int char void short long float double signed unsigned "
+        "struct union enum typedef const static extern volatile register inline sizeof "
+        "include define",
+        "//", "/*", "*/", "\"'", NUMBER_FLOAT | NUMBER_ALNUM, 0
+    },
+    {
+        "python", ".py",
+        "and as assert break class continue def del elif else except finally for from "
+        "global if import in is lambda nonlocal not or pass raise return try while with "
+        "yield None True False",
+        "#", "", "", "\"'", NUMBER_FLOAT | NUMBER_ALNUM, 0
+    },
+    {
+        "javascript", ".js .mjs .ts",
+        "break case catch class const continue default delete do else export extends "
+        "finally for function if import in instanceof let new return switch this throw "
+        "try typeof var void while yield async await null true false",
+        "//", "/*", "*/", "\"'`", NUMBER_FLOAT | NUMBER_ALNUM, 0
+    },
+    {
+        "shell", ".sh .bash",
+        "if then else elif fi for while until do done case esac function in return "
+        "export local",
+        "#", "", "", "\"'", 0, 0
+    },
+    {
+        "sql", ".sql",
+        "select from where insert into values update set delete create table drop alter "
+        "join left right inner outer on group by order having and or not null as",
+        "--", "/*", "*/", "'\"", NUMBER_FLOAT, 1
+    }
+};
+
+static GrammarRegistry registry;
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t registryOnce = PTHREAD_ONCE_INIT;
+
+// ========== KEYWORD PERFECT HASH ==========
+
+// Seeded FNV-1a over the (optionally case-folded) word
+static unsigned int hashKeyword(const char *word, int length, unsigned int seed, int ignoreCase) {
+    unsigned int h = 2166136261u ^ seed;
+    for (int i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)word[i];
+        if (ignoreCase && c < 0x80) {
+            c = asciiFoldTable[c];
+        }
+        h = (h ^ c) * 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+// Compare a word against a keyword of the same length
+static int keywordEquals(const char *keyword, const char *word, int length, int ignoreCase) {
+    for (int i = 0; i < length; i++) {
+        unsigned char a = (unsigned char)keyword[i];
+        unsigned char b = (unsigned char)word[i];
+        if (ignoreCase && a < 0x80 && b < 0x80) {
+            a = asciiFoldTable[a];
+            b = asciiFoldTable[b];
+        }
+        if (a != b) {
+            return 0;
+        }
+    }
+    return keyword[length] == '\0';
+}
+
+// Place the keywords so that no two share a slot
+// ALGORITHM: Seed search - try seeds for a table of twice the keyword count,
+// doubling the table if no seed works; done once per grammar at load time
+static void buildKeywordHash(Grammar *g, char **keywords, int count) {
+    int slots = 1;
+    while (slots < count * 2) {
+        slots *= 2;
+    }
+
+    for (;;) {
+        char **table = (char **)calloc(slots, sizeof(char *));
+        for (unsigned int seed = 1; seed <= 256; seed++) {
+            int collision = 0;
+            for (int k = 0; k < count && !collision; k++) {
+                int len = strlen(keywords[k]);
+                int slot = hashKeyword(keywords[k], len, seed, g->ignoreCase) & (slots - 1);
+                if (table[slot] != NULL && !keywordEquals(table[slot], keywords[k], len, g->ignoreCase)) {
+                    collision = 1;
+                }
+                table[slot] = keywords[k];
+            }
+            if (!collision) {
+                g->keywordSlots = table;
+                g->keywordMask = slots - 1;
+                g->keywordSeed = seed;
+                return;
+            }
+            memset(table, 0, slots * sizeof(char *));
+        }
+        free(table);
+        slots *= 2;
+    }
+}
+
+// Check whether word[0..length) is a keyword of the grammar
+// ALGORITHM: Perfect hash - one slot probe and one compare, O(length)
+int isGrammarKeyword(const Grammar *g, const char *word, int length) {
+    if (g->keywordSlots == NULL) {
+        return 0;
+    }
+    int slot = hashKeyword(word, length, g->keywordSeed, g->ignoreCase) & g->keywordMask;
+    const char *candidate = g->keywordSlots[slot];
+    return candidate != NULL && keywordEquals(candidate, word, length, g->ignoreCase);
+}
+
+// ========== TABLE COMPILER ==========
+
+// Fixed character classes; delimiter characters get classes of their own
+#define CC_SPACE     0
+#define CC_NEWLINE   1
+#define CC_LETTER    2   // Letters, '_' and UTF-8 bytes
+#define CC_DIGIT     3
+#define CC_BACKSLASH 4
+#define CC_DOT       5
+#define CC_OTHER     6
+#define CC_FIXED     7
+
+// Fixed states; string and comment states are allocated per grammar
+#define STATE_IDENT  1
+#define STATE_NUMBER 2
+
+// Compiler scratch state
+typedef struct {
+    Grammar *g;
+    int stateCount;
+    int classCount;
+} GrammarBuilder;
+
+// Give c its own character class (delimiters must be punctuation)
+static int addDelimiterClass(GrammarBuilder *b, unsigned char c) {
+    int cls = b->g->charClass[c];
+    if (cls > CC_OTHER) {
+        return cls;   // Already has one
+    }
+    if (cls != CC_OTHER || b->classCount == GRAMMAR_MAX_CLASSES) {
+        return -1;
+    }
+    b->g->charClass[c] = b->classCount;
+    return b->classCount++;
+}
+
+// Allocate a state whose row is filled with one entry
+static int addState(GrammarBuilder *b, unsigned char fill, int tokenType) {
+    if (b->stateCount == GRAMMAR_MAX_STATES) {
+        return -1;
+    }
+    int state = b->stateCount++;
+    memset(b->g->transitions[state], fill, GRAMMAR_MAX_CLASSES);
+    b->g->stateTokenType[state] = tokenType;
+    return state;
+}
+
+// Route the opener (1 or 2 characters) from the start state into target
+// Openers sharing a first character share one prefix state (e.g. "//" and "/*")
+static int addOpener(GrammarBuilder *b, const char *opener, int target) {
+    Grammar *g = b->g;
+    int first = addDelimiterClass(b, (unsigned char)opener[0]);
+    if (first < 0) {
+        return 0;
+    }
+    unsigned char entry = g->transitions[LEX_START][first];
+
+    if (opener[1] == '\0') {
+        if (entry != TRANSITION(ACT_SINGLE, LEX_START)) {
+            return 0;
+        }
+        g->transitions[LEX_START][first] = TRANSITION(ACT_BEGIN, target);
+        return 1;
+    }
+
+    int second = addDelimiterClass(b, (unsigned char)opener[1]);
+    if (second < 0) {
+        return 0;
+    }
+    int prefix;
+    if (entry == TRANSITION(ACT_SINGLE, LEX_START)) {
+        prefix = addState(b, TRANSITION(ACT_END_BEFORE, LEX_START), TOKEN_PUNCTUATION);
+        if (prefix < 0) {
+            return 0;
+        }
+        g->transitions[LEX_START][first] = TRANSITION(ACT_BEGIN, prefix);
+    } else {
+        prefix = entry & 0x0F;
+        if ((entry >> 4) != ACT_BEGIN || g->stateTokenType[prefix] != TOKEN_PUNCTUATION) {
+            return 0;
+        }
+    }
+    g->transitions[prefix][second] = TRANSITION(ACT_NEXT, target);
+    return 1;
+}
+
+// Build the character classes and the DFA for a definition
+// Returns 0 if the definition does not fit the table limits
+static int compileTables(Grammar *g, const GrammarDef *def) {
+    GrammarBuilder b = {g, 0, CC_FIXED};
+
+    for (int c = 0; c < 256; c++) {
+        if (c == '\n') {
+            g->charClass[c] = CC_NEWLINE;
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+            g->charClass[c] = CC_SPACE;
+        } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80) {
+            g->charClass[c] = CC_LETTER;
+        } else if (c >= '0' && c <= '9') {
+            g->charClass[c] = CC_DIGIT;
+        } else if (c == '\\') {
+            g->charClass[c] = CC_BACKSLASH;
+        } else if (c == '.') {
+            g->charClass[c] = CC_DOT;
+        } else {
+            g->charClass[c] = CC_OTHER;
+        }
+    }
+
+    // Start: skip whitespace, begin identifiers and numbers, punctuation otherwise
+    addState(&b, TRANSITION(ACT_SINGLE, LEX_START), TOKEN_PUNCTUATION);
+    g->transitions[LEX_START][CC_SPACE] = TRANSITION(ACT_SKIP, LEX_START);
+    g->transitions[LEX_START][CC_NEWLINE] = TRANSITION(ACT_SKIP, LEX_START);
+    g->transitions[LEX_START][CC_LETTER] = TRANSITION(ACT_BEGIN, STATE_IDENT);
+    g->transitions[LEX_START][CC_DIGIT] = TRANSITION(ACT_BEGIN, STATE_NUMBER);
+
+    addState(&b, TRANSITION(ACT_END_BEFORE, LEX_START), TOKEN_IDENTIFIER);
+    g->transitions[STATE_IDENT][CC_LETTER] = TRANSITION(ACT_NEXT, STATE_IDENT);
+    g->transitions[STATE_IDENT][CC_DIGIT] = TRANSITION(ACT_NEXT, STATE_IDENT);
+    g->identState = STATE_IDENT;
+
+    addState(&b, TRANSITION(ACT_END_BEFORE, LEX_START), TOKEN_NUMBER);
+    g->transitions[STATE_NUMBER][CC_DIGIT] = TRANSITION(ACT_NEXT, STATE_NUMBER);
+    if (def->numberFlags & NUMBER_FLOAT) {
+        g->transitions[STATE_NUMBER][CC_DOT] = TRANSITION(ACT_NEXT, STATE_NUMBER);
+    }
+    if (def->numberFlags & NUMBER_ALNUM) {
+        g->transitions[STATE_NUMBER][CC_LETTER] = TRANSITION(ACT_NEXT, STATE_NUMBER);
+    }
+
+    // Strings: end at the same quote or at a newline; a backslash escapes one character
+    int quoteCount = strlen(def->quotes);
+    if (quoteCount > GRAMMAR_MAX_QUOTES) {
+        return 0;
+    }
+    for (int q = 0; q < quoteCount; q++) {
+        int cls = addDelimiterClass(&b, (unsigned char)def->quotes[q]);
+        if (cls < 0 || g->transitions[LEX_START][cls] != TRANSITION(ACT_SINGLE, LEX_START)) {
+            return 0;
+        }
+        int body = addState(&b, 0, TOKEN_STRING);
+        int escape = addState(&b, 0, TOKEN_STRING);
+        if (body < 0 || escape < 0) {
+            return 0;
+        }
+        memset(g->transitions[body], TRANSITION(ACT_NEXT, body), GRAMMAR_MAX_CLASSES);
+        memset(g->transitions[escape], TRANSITION(ACT_NEXT, body), GRAMMAR_MAX_CLASSES);
+        g->transitions[body][CC_NEWLINE] = TRANSITION(ACT_END_BEFORE, LEX_START);
+        g->transitions[body][CC_BACKSLASH] = TRANSITION(ACT_NEXT, escape);
+        g->transitions[body][cls] = TRANSITION(ACT_END_AFTER, LEX_START);
+        g->transitions[LEX_START][cls] = TRANSITION(ACT_BEGIN, body);
+    }
+
+    // Line comment: runs to the end of the line
+    int lineLen = strlen(def->lineComment);
+    if (lineLen > GRAMMAR_MAX_DELIMITER) {
+        return 0;
+    }
+    if (lineLen > 0) {
+        int line = addState(&b, 0, TOKEN_COMMENT);
+        if (line < 0) {
+            return 0;
+        }
+        memset(g->transitions[line], TRANSITION(ACT_NEXT, line), GRAMMAR_MAX_CLASSES);
+        g->transitions[line][CC_NEWLINE] = TRANSITION(ACT_END_BEFORE, LEX_START);
+        if (!addOpener(&b, def->lineComment, line)) {
+            return 0;
+        }
+    }
+
+    // Block comment: runs across lines until the closing delimiter
+    int openLen = strlen(def->blockOpen);
+    int closeLen = strlen(def->blockClose);
+    if (openLen > GRAMMAR_MAX_DELIMITER || closeLen > GRAMMAR_MAX_DELIMITER ||
+        (openLen == 0) != (closeLen == 0)) {
+        return 0;
+    }
+    if (openLen > 0) {
+        int block = addState(&b, 0, TOKEN_COMMENT);
+        if (block < 0) {
+            return 0;
+        }
+        memset(g->transitions[block], TRANSITION(ACT_NEXT, block), GRAMMAR_MAX_CLASSES);
+
+        int closeFirst = addDelimiterClass(&b, (unsigned char)def->blockClose[0]);
+        if (closeFirst < 0) {
+            return 0;
+        }
+        if (closeLen == 1) {
+            g->transitions[block][closeFirst] = TRANSITION(ACT_END_AFTER, LEX_START);
+        } else {
+            int closeSecond = addDelimiterClass(&b, (unsigned char)def->blockClose[1]);
+            int closing = addState(&b, 0, TOKEN_COMMENT);
+            if (closeSecond < 0 || closing < 0) {
+                return 0;
+            }
+            memset(g->transitions[closing], TRANSITION(ACT_NEXT, block), GRAMMAR_MAX_CLASSES);
+            g->transitions[block][closeFirst] = TRANSITION(ACT_NEXT, closing);
+            g->transitions[closing][closeFirst] = TRANSITION(ACT_NEXT, closing);
+            g->transitions[closing][closeSecond] = TRANSITION(ACT_END_AFTER, LEX_START);
+        }
+        if (!addOpener(&b, def->blockOpen, block)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// Split a space-separated list into malloc'd storage; returns the item count
+static int splitWords(const char *list, char **storage, char ***items) {
+    int length = strlen(list);
+    *storage = (char *)malloc(length + 1);
+    memcpy(*storage, list, length + 1);
+
+    int count = 0;
+    int capacity = 16;
+    *items = (char **)malloc(capacity * sizeof(char *));
+    for (char *word = strtok(*storage, " \t"); word != NULL; word = strtok(NULL, " \t")) {
+        if (count == capacity) {
+            capacity *= 2;
+            *items = (char **)realloc(*items, capacity * sizeof(char *));
+        }
+        (*items)[count++] = word;
+    }
+    return count;
+}
+
+// Free a compiled grammar
+static void freeGrammar(Grammar *g) {
+    free(g->keywordSlots);
+    free(g->keywordStorage);
+    free(g);
+}
+
+// Compile a definition; returns NULL (with a message) if it is invalid
+static Grammar* compileGrammar(const GrammarDef *def) {
+    Grammar *g = (Grammar *)calloc(1, sizeof(Grammar));
+    strncpy(g->name, def->name, GRAMMAR_MAX_NAME - 1);
+    g->ignoreCase = def->ignoreCase;
+
+    if (!compileTables(g, def)) {
+        printf("Grammar '%s': delimiters do not fit the lexer tables.\n", def->name);
+        freeGrammar(g);
+        return NULL;
+    }
+
+    char *extensionStorage;
+    char **extensions;
+    int count = splitWords(def->extensions, &extensionStorage, &extensions);
+    for (int i = 0; i < count && g->extensionCount < GRAMMAR_MAX_EXTENSIONS; i++) {
+        strncpy(g->extensions[g->extensionCount++], extensions[i], 15);
+    }
+    free(extensions);
+    free(extensionStorage);
+
+    char **keywords;
+    count = splitWords(def->keywords, &g->keywordStorage, &keywords);
+    if (count > 0) {
+        buildKeywordHash(g, keywords, count);
+    }
+    free(keywords);
+
+    return g;
+}
+
+// ========== REGISTRY ==========
+
+static void addToRegistry(Grammar *g) {
+    if (registry.count == registry.capacity) {
+        registry.capacity = (registry.capacity == 0) ? 8 : registry.capacity * 2;
+        registry.grammars = (Grammar **)realloc(registry.grammars, registry.capacity * sizeof(Grammar *));
+    }
+    registry.grammars[registry.count++] = g;
+}
+
+static Grammar* findGrammarLocked(const char *name) {
+    for (int i = 0; i < registry.count; i++) {
+        if (strcmp(registry.grammars[i]->name, name) == 0) {
+            return registry.grammars[i];
+        }
+    }
+    return NULL;
+}
+
+// Compile and add a language unless one of the same name exists
+static const Grammar* addGrammarDef(const GrammarDef *def) {
+    pthread_mutex_lock(&registryLock);
+    Grammar *g = findGrammarLocked(def->name);
+    if (g != NULL) {
+        printf("Grammar '%s' is already registered.\n", def->name);
+    } else {
+        g = compileGrammar(def);
+        if (g != NULL) {
+            addToRegistry(g);
+        }
+    }
+    pthread_mutex_unlock(&registryLock);
+    return g;
+}
+
+// Copy the value of a "key = value" line, trimming spaces
+static void readValue(const char *value, char *out, int outSize) {
+    while (*value == ' ' || *value == '\t') {
+        value++;
+    }
+    int length = strcspn(value, "\r\n");
+    while (length > 0 && (value[length - 1] == ' ' || value[length - 1] == '\t')) {
+        length--;
+    }
+    if (length >= outSize) {
+        length = outSize - 1;
+    }
+    memcpy(out, value, length);
+    out[length] = '\0';
+}
+
+// Grammar file section being read
+typedef struct {
+    char name[GRAMMAR_MAX_NAME];
+    char extensions[256];
+    char keywords[4096];
+    char lineComment[8];
+    char blockOpen[8];
+    char blockClose[8];
+    char quotes[8];
+    int numberFlags;
+    int ignoreCase;
+} GrammarSection;
+
+static int registerSection(GrammarSection *s) {
+    GrammarDef def = {
+        s->name, s->extensions, s->keywords, s->lineComment, s->blockOpen,
+        s->blockClose, s->quotes, s->numberFlags, s->ignoreCase
+    };
+    return addGrammarDef(&def) != NULL;
+}
+
+// Read language definitions from a file of sections:
+//   [name]
+//   extensions = .lua
+//   keywords = and break do        (may repeat)
+//   line_comment = --
+//   block_comment = /* */
+//   quotes = "'
+//   numbers = float alnum
+//   ignore_case = yes
+// Returns the number of grammars registered
+static int readGrammarFile(const char *filename) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        return 0;
+    }
+
+    GrammarSection section;
+    int inSection = 0;
+    int loaded = 0;
+    char line[4096];
+    char value[4096];
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char *p = line;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') {
+            continue;
+        }
+
+        if (*p == '[') {
+            if (inSection) {
+                loaded += registerSection(&section);
+            }
+            memset(&section, 0, sizeof(section));
+            int length = strcspn(p + 1, "]\r\n");
+            if (length >= GRAMMAR_MAX_NAME) {
+                length = GRAMMAR_MAX_NAME - 1;
+            }
+            memcpy(section.name, p + 1, length);
+            inSection = 1;
+            continue;
+        }
+
+        char *equals = strchr(p, '=');
+        if (!inSection || equals == NULL) {
+            continue;
+        }
+        *equals = '\0';
+        char key[64];
+        readValue(p, key, sizeof(key));
+        readValue(equals + 1, value, sizeof(value));
+
+        if (strcmp(key, "extensions") == 0) {
+            readValue(value, section.extensions, sizeof(section.extensions));
+        } else if (strcmp(key, "keywords") == 0) {
+            int used = strlen(section.keywords);
+            snprintf(section.keywords + used, sizeof(section.keywords) - used,
+                     used > 0 ? " %s" : "%s", value);
+        } else if (strcmp(key, "line_comment") == 0) {
+            readValue(value, section.lineComment, sizeof(section.lineComment));
+        } else if (strcmp(key, "block_comment") == 0) {
+            sscanf(value, "%7s %7s", section.blockOpen, section.blockClose);
+        } else if (strcmp(key, "quotes") == 0) {
+            readValue(value, section.quotes, sizeof(section.quotes));
+        } else if (strcmp(key, "numbers") == 0) {
+            section.numberFlags = (strstr(value, "float") ? NUMBER_FLOAT : 0) |
+                                  (strstr(value, "alnum") ? NUMBER_ALNUM : 0);
+        } else if (strcmp(key, "ignore_case") == 0) {
+            section.ignoreCase = (strcmp(value, "yes") == 0 || strcmp(value, "1") == 0);
+        }
+    }
+    if (inSection) {
+        loaded += registerSection(&section);
+    }
+
+    fclose(file);
+    return loaded;
+}
+
+// Grammar file loaded with the built-in grammars, if present
+#define GRAMMAR_FILE "grammars.txt"
+
+static void createRegistry(void) {
+    int count = sizeof(builtinGrammars) / sizeof(builtinGrammars[0]);
+    for (int i = 0; i < count; i++) {
+        addGrammarDef(&builtinGrammars[i]);
+    }
+    readGrammarFile(GRAMMAR_FILE);
+}
+
+// Shared registry (built-in grammars and GRAMMAR_FILE are compiled on first use)
+GrammarRegistry* getGrammarRegistry(void) {
+    pthread_once(&registryOnce, createRegistry);
+    return &registry;
+}
+
+// Compile and register a language; an existing grammar of the same name is kept
+// (tabs may still be using it)
+const Grammar* registerGrammar(const GrammarDef *def) {
+    getGrammarRegistry();
+    return addGrammarDef(def);
+}
+
+// Load extra language definitions; returns the number of grammars registered
+int loadGrammarFile(const char *filename) {
+    getGrammarRegistry();
+    return readGrammarFile(filename);
+}
+
+// Find a grammar by language name
+const Grammar* findGrammar(const char *name) {
+    getGrammarRegistry();
+    pthread_mutex_lock(&registryLock);
+    Grammar *g = findGrammarLocked(name);
+    pthread_mutex_unlock(&registryLock);
+    return g;
+}
+
+// Find the grammar for a file by its extension, or NULL if none matches
+const Grammar* findGrammarForFile(const char *filename) {
+    const char *dot = strrchr(filename, '.');
+    if (dot == NULL) {
+        return NULL;
+    }
+
+    getGrammarRegistry();
+    pthread_mutex_lock(&registryLock);
+    Grammar *found = NULL;
+    for (int i = 0; i < registry.count && found == NULL; i++) {
+        Grammar *g = registry.grammars[i];
+        for (int k = 0; k < g->extensionCount; k++) {
+            if (strcmp(g->extensions[k], dot) == 0) {
+                found = g;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&registryLock);
+    return found;
+}
+
+// Grammar used when the extension is unknown
+const Grammar* getDefaultGrammar(void) {
+    GrammarRegistry *r = getGrammarRegistry();
+    return (r->count > 0) ? r->grammars[0] : NULL;
+}
+
+// Free every grammar (call once at exit, after all tabs are closed)
+void freeGrammarRegistry(void) {
+    pthread_mutex_lock(&registryLock);
+    for (int i = 0; i < registry.count; i++) {
+        freeGrammar(registry.grammars[i]);
+    }
+    free(registry.grammars);
+    registry.grammars = NULL;
+    registry.count = 0;
+    registry.capacity = 0;
+    pthread_mutex_unlock(&registryLock);
+}
@@ -0,0 +1,79 @@
+#ifndef GRAMMAR_H
+#define GRAMMAR_H
+
+// GRAMMAR REGISTRY for the syntax highlighter
+// A language definition (keywords, comment and string delimiters, number
+// format) is compiled once into lexer tables when it is registered; every tab
+// editing a file of that language shares the compiled grammar
+
+#define GRAMMAR_MAX_STATES     16   // Lexer states (fit in the low nibble of a transition)
+#define GRAMMAR_MAX_CLASSES    16   // Character classes
+#define GRAMMAR_MAX_EXTENSIONS 8
+#define GRAMMAR_MAX_NAME       32
+#define GRAMMAR_MAX_DELIMITER  2    // Longest comment delimiter
+#define GRAMMAR_MAX_QUOTES     3    // String delimiter characters
+
+// Number formats (combine with |)
+#define NUMBER_FLOAT 1   // '.' continues a number (3.14)
+#define NUMBER_ALNUM 2   // Letters and '_' continue a number (0x1F, 1e9, 10UL)
+
+// Transition table entries: action in the high nibble, next state in the low nibble
+#define ACT_NEXT       0   // Character joins the current token
+#define ACT_BEGIN      1   // A token starts at this character
+#define ACT_END_BEFORE 2   // Token ends before this character; re-read it from the start state
+#define ACT_END_AFTER  3   // Token ends with this character
+#define ACT_SINGLE     4   // One-character punctuation token
+#define ACT_SKIP       5   // Whitespace between tokens
+#define TRANSITION(action, state) (((action) << 4) | (state))
+
+// Language definition as written by hand (built-in table or grammar file)
+typedef struct {
+    const char *name;          // Language name, e.g. "c"
+    const char *extensions;    // Space-separated, e.g. ".c .h"
+    const char *keywords;      // Space-separated keywords
+    const char *lineComment;   // Line comment opener ("" for none)
+    const char *blockOpen;     // Block comment delimiters ("" for none)
+    const char *blockClose;
+    const char *quotes;        // String delimiter characters, e.g. "\"'"
+    int numberFlags;           // NUMBER_* flags
+    int ignoreCase;            // Keywords match case-insensitively
+} GrammarDef;
+
+// Compiled grammar
+// DATA STRUCTURE: DFA transition table over per-grammar character classes,
+// plus a perfect hash table of keywords found by a seed search at load time
+typedef struct {
+    char name[GRAMMAR_MAX_NAME];
+    char extensions[GRAMMAR_MAX_EXTENSIONS][16];
+    int extensionCount;
+
+    unsigned char charClass[256];
+    unsigned char transitions[GRAMMAR_MAX_STATES][GRAMMAR_MAX_CLASSES];
+    unsigned char stateTokenType[GRAMMAR_MAX_STATES];  // Token produced by each state
+    int identState;             // State whose tokens are checked against the keywords
+
+    char **keywordSlots;        // Perfect hash: one keyword (or NULL) per slot
+    int keywordMask;            // Slot count - 1 (slot count is a power of two)
+    unsigned int keywordSeed;   // Hash seed with no collisions among the keywords
+    char *keywordStorage;       // Backing storage for the keyword strings
+    int ignoreCase;
+} Grammar;
+
+// Registry of compiled grammars, shared by all tabs
+typedef struct {
+    Grammar **grammars;
+    int count;
+    int capacity;
+} GrammarRegistry;
+
+// Function declarations
+GrammarRegistry* getGrammarRegistry(void);
+const Grammar* registerGrammar(const GrammarDef *def);
+int loadGrammarFile(const char *filename);
+const Grammar* findGrammar(const char *name);
+const Grammar* findGrammarForFile(const char *filename);
+const Grammar* getDefaultGrammar(void);
+int isGrammarKeyword(const Grammar *g, const char *word, int length);
+void freeGrammarRegistry(void);
+
+#endif
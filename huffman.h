@@ -0,0 +1,19 @@
+#ifndef HUFFMAN_H
+#define HUFFMAN_H
+
+#include <stdint.h>
+
+// HUFFMAN CODEC shared with the WebAssembly build
+// The implementation is src/c/huffman.c, compiled into the native editor as is
+// A compressed buffer is self-describing (mode byte, length, code lengths)
+// and is never larger than huffman_max_compressed_size(length)
+
+// Function declarations
+void huffman_count_frequencies(const unsigned char *input, int length, uint32_t *freq);
+int huffman_build_code_lengths(const uint32_t *freq, unsigned char *lengths, int max_length);
+int huffman_max_compressed_size(int length);
+int huffman_compress(const unsigned char *input, int length, unsigned char *output, int capacity);
+int huffman_decompressed_size(const unsigned char *input, int length);
+int huffman_decompress(const unsigned char *input, int length, unsigned char *output, int capacity);
+
+#endif
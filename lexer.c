@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lexer.h"
+
+// ========== TOKEN ARRAY ==========
+
+// Initialize an empty token array
+void initTokenArray(TokenArray *ta) {
+    ta->tokens = NULL;
+    ta->count = 0;
+    ta->capacity = 0;
+}
+
+// Free the token array
+void freeTokenArray(TokenArray *ta) {
+    free(ta->tokens);
+    initTokenArray(ta);
+}
+
+// Append a token, classifying identifiers that are keywords
+static void emitToken(const Grammar *g, TokenArray *out, const char *text, int start,
+                      int end, int state, int baseOffset) {
+    if (out->count == out->capacity) {
+        out->capacity = (out->capacity == 0) ? 64 : out->capacity * 2;
+        out->tokens = (Token *)realloc(out->tokens, out->capacity * sizeof(Token));
+    }
+
+    Token *tok = &out->tokens[out->count++];
+    tok->start = baseOffset + start;
+    tok->length = end - start;
+    tok->type = g->stateTokenType[state];
+    tok->first = (unsigned char)text[start];
+    if (state == g->identState && isGrammarKeyword(g, text + start, end - start)) {
+        tok->type = TOKEN_KEYWORD;
+    }
+}
+
+// ========== LEXER ==========
+
+// Lex text[0..length) with grammar g starting in startState, appending tokens to out
+// Returns the state at the end of the text; a token still open at the end is
+// emitted up to the end, and the returned state lets the next text continue it
+// ALGORITHM: DFA - one table lookup per byte, O(n)
+int lexText(const Grammar *g, const char *text, int length, int baseOffset, int startState,
+            TokenArray *out) {
+    const unsigned char *p = (const unsigned char *)text;
+    int state = startState;
+    int tokenStart = 0;
+    int i = 0;
+
+    while (i < length) {
+        unsigned char entry = g->transitions[state][g->charClass[p[i]]];
+        int next = entry & 0x0F;
+
+        switch (entry >> 4) {
+            case ACT_NEXT:
+                state = next;
+                i++;
+                break;
+            case ACT_BEGIN:
+                tokenStart = i;
+                state = next;
+                i++;
+                break;
+            case ACT_END_BEFORE:
+                emitToken(g, out, text, tokenStart, i, state, baseOffset);
+                state = LEX_START;
+                break;  // Re-read this character from LEX_START
+            case ACT_END_AFTER:
+                emitToken(g, out, text, tokenStart, i + 1, state, baseOffset);
+                state = LEX_START;
+                i++;
+                break;
+            case ACT_SINGLE:
+                emitToken(g, out, text, i, i + 1, LEX_START, baseOffset);
+                i++;
+                break;
+            default:  // ACT_SKIP
+                i++;
+                break;
+        }
+    }
+
+    if (state != LEX_START && tokenStart < length) {
+        emitToken(g, out, text, tokenStart, length, state, baseOffset);
+    }
+    return state;
+}
@@ -0,0 +1,43 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include "grammar.h"
+
+// Table-driven LEXER for syntax highlighting
+// Runs a grammar's DFA over its character classes to split text into
+// identifiers, keywords, numbers, strings and comments in one pass
+
+// Token types
+#define TOKEN_IDENTIFIER  0
+#define TOKEN_KEYWORD     1
+#define TOKEN_NUMBER      2
+#define TOKEN_STRING      3
+#define TOKEN_COMMENT     4
+#define TOKEN_PUNCTUATION 5
+
+// Start state of every grammar (any other state at the end of a text means a
+// token continues into the next text, e.g. a block comment across lines)
+#define LEX_START 0
+
+// A token span [start, start + length) in document offsets
+typedef struct {
+    int start;
+    int length;
+    unsigned char type;  // TOKEN_*
+    unsigned char first; // First character (identifies punctuation without the text)
+} Token;
+
+// Growable array of tokens in document order
+typedef struct {
+    Token *tokens;
+    int count;
+    int capacity;
+} TokenArray;
+
+// Function declarations
+void initTokenArray(TokenArray *ta);
+void freeTokenArray(TokenArray *ta);
+int lexText(const Grammar *g, const char *text, int length, int baseOffset, int startState,
+            TokenArray *out);
+
+#endif
@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "linecache.h"
+
+#define LINE_INITIAL_CAPACITY 16   // Power of two, like every later capacity
+
+// Number of lines stored on both sides of the gap
+static int lineCount(LineCache *lc) {
+    return lc->gapStart + (lc->capacity - lc->gapEnd);
+}
+
+// Physical slot of a line index
+static int lineSlot(LineCache *lc, int index) {
+    return (index < lc->gapStart) ? index : index + (lc->gapEnd - lc->gapStart);
+}
+
+// Line index of an occupied slot
+static int slotLine(LineCache *lc, int slot) {
+    return (slot < lc->gapStart) ? slot : slot - (lc->gapEnd - lc->gapStart);
+}
+
+// ========== LINE TREE ==========
+
+// Combine the summaries of two adjacent ranges
+static LineSummary combineSummary(LineSummary a, LineSummary b) {
+    LineSummary s;
+    s.length = a.length + b.length;
+    s.lines = a.lines + b.lines;
+    s.bracketSum = a.bracketSum + b.bracketSum;
+    s.bracketMin = (a.bracketSum + b.bracketMin < a.bracketMin) ? a.bracketSum + b.bracketMin : a.bracketMin;
+    return s;
+}
+
+// Leaf summary of one slot (gap slots are empty)
+static LineSummary slotSummary(LineCache *lc, int slot) {
+    LineSummary s = {0, 0, 0, 0};
+    if (slot < lc->gapStart || slot >= lc->gapEnd) {
+        LineEntry *line = &lc->lines[slot];
+        s.length = line->length;
+        s.lines = 1;
+        s.bracketSum = line->bracketSum;
+        s.bracketMin = line->bracketMin;
+    }
+    return s;
+}
+
+// Refresh a leaf and its ancestors - O(log n)
+static void updateSlot(LineCache *lc, int slot) {
+    int node = lc->capacity + slot;
+    lc->tree[node] = slotSummary(lc, slot);
+    for (node /= 2; node >= 1; node /= 2) {
+        lc->tree[node] = combineSummary(lc->tree[2 * node], lc->tree[2 * node + 1]);
+    }
+}
+
+// Rebuild the whole tree - O(capacity)
+static void rebuildTree(LineCache *lc) {
+    free(lc->tree);
+    lc->tree = (LineSummary *)malloc(2 * lc->capacity * sizeof(LineSummary));
+    for (int slot = 0; slot < lc->capacity; slot++) {
+        lc->tree[lc->capacity + slot] = slotSummary(lc, slot);
+    }
+    for (int node = lc->capacity - 1; node >= 1; node--) {
+        lc->tree[node] = combineSummary(lc->tree[2 * node], lc->tree[2 * node + 1]);
+    }
+}
+
+// ========== GAP ARRAY ==========
+
+// Grow the line array, keeping the gap in place
+static void growLines(LineCache *lc, int needed) {
+    int newCapacity = lc->capacity;
+    while (newCapacity - lineCount(lc) < needed) {
+        newCapacity *= 2;
+    }
+    if (newCapacity == lc->capacity) {
+        return;
+    }
+
+    LineEntry *lines = (LineEntry *)malloc(newCapacity * sizeof(LineEntry));
+    int tail = lc->capacity - lc->gapEnd;
+    memcpy(lines, lc->lines, lc->gapStart * sizeof(LineEntry));
+    memcpy(lines + newCapacity - tail, lc->lines + lc->gapEnd, tail * sizeof(LineEntry));
+    free(lc->lines);
+
+    lc->lines = lines;
+    lc->gapEnd = newCapacity - tail;
+    lc->capacity = newCapacity;
+    rebuildTree(lc);
+}
+
+// Move the line just before the gap to just after it
+static void shiftGapBack(LineCache *lc) {
+    lc->lines[--lc->gapEnd] = lc->lines[--lc->gapStart];
+    lc->gapOffset -= lc->lines[lc->gapEnd].length;
+    updateSlot(lc, lc->gapStart);
+    updateSlot(lc, lc->gapEnd);
+}
+
+// Move the line just after the gap to just before it
+static void shiftGapForward(LineCache *lc) {
+    lc->gapOffset += lc->lines[lc->gapEnd].length;
+    lc->lines[lc->gapStart++] = lc->lines[lc->gapEnd++];
+    updateSlot(lc, lc->gapStart - 1);
+    updateSlot(lc, lc->gapEnd - 1);
+}
+
+// Move the gap so the first line after it is the line containing pos
+// (the last line also contains the end of the document)
+// ALGORITHM: Gap buffer - cost is proportional to the lines crossed
+static void moveGap(LineCache *lc, int pos) {
+    while (lc->gapStart > 0 && (lc->gapOffset > pos || lc->gapEnd == lc->capacity)) {
+        shiftGapBack(lc);
+    }
+    while (lc->gapEnd + 1 < lc->capacity &&
+           lc->gapOffset + lc->lines[lc->gapEnd].length <= pos) {
+        shiftGapForward(lc);
+    }
+}
+
+// Reset to a single dirty line covering the whole document
+static void resetLines(LineCache *lc, int docLength) {
+    LineEntry line = {docLength, LEX_START, LEX_START, 1, NULL, 0, 0, 0};
+    lc->gapStart = 0;
+    lc->gapEnd = lc->capacity - 1;
+    lc->lines[lc->gapEnd] = line;
+    lc->gapOffset = 0;
+    lc->docLength = docLength;
+    rebuildTree(lc);
+
+    lc->hasDirty = 1;
+    lc->dirtyStart = 0;
+    lc->dirtyEnd = docLength;
+}
+
+// Initialize a cache for an empty document
+void initLineCache(LineCache *lc) {
+    lc->lines = (LineEntry *)malloc(LINE_INITIAL_CAPACITY * sizeof(LineEntry));
+    lc->capacity = LINE_INITIAL_CAPACITY;
+    lc->tree = NULL;
+    resetLines(lc, 0);
+}
+
+// Drop every cached line; the whole document is re-lexed on the next refresh
+void lineCacheInvalidateAll(LineCache *lc, int docLength) {
+    for (int i = 0; i < lineCount(lc); i++) {
+        free(getCachedLine(lc, i)->tokens);
+    }
+    resetLines(lc, docLength);
+}
+
+// Forget a line's tokens until it is re-lexed
+static void clearTokens(LineEntry *line) {
+    free(line->tokens);
+    line->tokens = NULL;
+    line->tokenCount = 0;
+    line->bracketSum = 0;
+    line->bracketMin = 0;
+}
+
+// Record an edit: 'removed' characters at pos replaced by 'inserted' characters
+// The lines touched by the edit are merged into one dirty line; it is split
+// again at its newlines when it is re-lexed
+void lineCacheNoteEdit(LineCache *lc, int pos, int inserted, int removed) {
+    int delta = inserted - removed;
+
+    moveGap(lc, pos);
+    LineEntry *line = &lc->lines[lc->gapEnd];
+    int lineStart = lc->gapOffset;
+
+    // A removal reaching the end of the line takes its '\n', joining the next line
+    while (lineStart + line->length <= pos + removed && lc->gapEnd + 1 < lc->capacity) {
+        LineEntry *next = &lc->lines[lc->gapEnd + 1];
+        next->length += line->length;
+        clearTokens(line);
+        lc->gapEnd++;
+        updateSlot(lc, lc->gapEnd - 1);
+        line = next;
+    }
+
+    line->length += delta;
+    line->dirty = 1;
+    clearTokens(line);
+    updateSlot(lc, lc->gapEnd);
+    lc->docLength += delta;
+
+    // Shift the dirty bounds into the new coordinates and cover this line
+    int lineEnd = lineStart + line->length;
+    if (!lc->hasDirty) {
+        lc->hasDirty = 1;
+        lc->dirtyStart = lineStart;
+        lc->dirtyEnd = lineEnd;
+        return;
+    }
+    if (lc->dirtyStart > pos + removed) {
+        lc->dirtyStart += delta;
+    } else if (lc->dirtyStart > pos) {
+        lc->dirtyStart = pos;
+    }
+    if (lc->dirtyEnd > pos + removed) {
+        lc->dirtyEnd += delta;
+    } else if (lc->dirtyEnd > pos) {
+        lc->dirtyEnd = pos + inserted;
+    }
+    if (lineStart < lc->dirtyStart) lc->dirtyStart = lineStart;
+    if (lineEnd > lc->dirtyEnd) lc->dirtyEnd = lineEnd;
+}
+
+// Balance change of a bracket character: +1 opening, -1 closing, 0 otherwise
+int bracketDelta(unsigned char c) {
+    if (c == '(' || c == '[' || c == '{') {
+        return 1;
+    }
+    if (c == ')' || c == ']' || c == '}') {
+        return -1;
+    }
+    return 0;
+}
+
+// Lex one line and insert it before the gap
+static void pushLine(LineCache *lc, const Grammar *g, const char *text, int length,
+                     int startState) {
+    TokenArray tokens;
+    initTokenArray(&tokens);
+
+    LineEntry line;
+    line.length = length;
+    line.startState = startState;
+    line.endState = lexText(g, text, length, 0, startState, &tokens);
+    line.dirty = 0;
+    line.tokenCount = tokens.count;
+    line.tokens = NULL;
+    if (tokens.count > 0) {
+        line.tokens = (Token *)realloc(tokens.tokens, tokens.count * sizeof(Token));
+    } else {
+        freeTokenArray(&tokens);
+    }
+
+    // Brackets are single-character punctuation tokens, never string or comment text
+    line.bracketSum = 0;
+    line.bracketMin = 0;
+    for (int k = 0; k < line.tokenCount; k++) {
+        Token *tok = &line.tokens[k];
+        if (tok->type == TOKEN_PUNCTUATION && tok->length == 1) {
+            line.bracketSum += bracketDelta(tok->first);
+            if (line.bracketSum < line.bracketMin) {
+                line.bracketMin = line.bracketSum;
+            }
+        }
+    }
+
+    growLines(lc, 1);
+    lc->lines[lc->gapStart++] = line;
+    lc->gapOffset += length;
+    updateSlot(lc, lc->gapStart - 1);
+}
+
+// Re-lex the dirty lines with grammar g, continuing past them only while a
+// line's end state differs from the start state cached for the next line
+// Returns the number of lines lexed
+// ALGORITHM: Incremental lexing - O(changed lines), not O(document)
+int refreshLineCache(LineCache *lc, const Grammar *g, LineTextFn fetchText, void *ctx) {
+    if (!lc->hasDirty) {
+        return 0;
+    }
+
+    moveGap(lc, lc->dirtyStart);
+    int state = (lc->gapStart > 0) ? lc->lines[lc->gapStart - 1].endState : LEX_START;
+    int lexed = 0;
+
+    while (lc->gapEnd < lc->capacity) {
+        LineEntry *line = &lc->lines[lc->gapEnd];
+
+        // Unchanged line entered in the state it was lexed with: still valid
+        if (!line->dirty && line->startState == state) {
+            if (lc->gapOffset >= lc->dirtyEnd) {
+                break;
+            }
+            state = line->endState;
+            shiftGapForward(lc);
+            continue;
+        }
+
+        // Take the line out and lex it, splitting it at every '\n'
+        LineEntry old = *line;
+        lc->gapEnd++;
+        updateSlot(lc, lc->gapEnd - 1);
+        int isLast = (lc->gapEnd == lc->capacity);
+        char *text = fetchText(ctx, lc->gapOffset, lc->gapOffset + old.length);
+
+        int start = 0;
+        for (int i = 0; i < old.length; i++) {
+            if (text[i] == '\n') {
+                pushLine(lc, g, text + start, i + 1 - start, state);
+                state = lc->lines[lc->gapStart - 1].endState;
+                start = i + 1;
+                lexed++;
+            }
+        }
+        if (start < old.length || isLast) {
+            pushLine(lc, g, text + start, old.length - start, state);
+            state = lc->lines[lc->gapStart - 1].endState;
+            lexed++;
+        }
+
+        free(text);
+        free(old.tokens);
+    }
+
+    lc->hasDirty = 0;
+    return lexed;
+}
+
+// Number of lines in the document
+int getCachedLineCount(LineCache *lc) {
+    return lineCount(lc);
+}
+
+// Get a line by its index in document order
+LineEntry* getCachedLine(LineCache *lc, int index) {
+    return &lc->lines[lineSlot(lc, index)];
+}
+
+// Index of the line containing pos; lineStart receives its document offset
+// ALGORITHM: Descend the line tree by length - O(log n)
+int findLineAt(LineCache *lc, int pos, int *lineStart) {
+    int index = 0;
+    int start = 0;
+
+    if (pos >= lc->tree[1].length) {
+        // End of the document belongs to the last line
+        index = lineCount(lc) - 1;
+        start = lc->tree[1].length - getCachedLine(lc, index)->length;
+    } else {
+        int node = 1;
+        while (node < lc->capacity) {
+            LineSummary left = lc->tree[2 * node];
+            if (pos < start + left.length) {
+                node = 2 * node;
+            } else {
+                start += left.length;
+                index += left.lines;
+                node = 2 * node + 1;
+            }
+        }
+    }
+
+    if (lineStart != NULL) {
+        *lineStart = start;
+    }
+    return index;
+}
+
+// Sum of the slot summaries before a slot - O(log n)
+static LineSummary summaryBefore(LineCache *lc, int slot) {
+    LineSummary s = {0, 0, 0, 0};
+    int node = 1;
+    int lo = 0;
+    int hi = lc->capacity;
+    while (node < lc->capacity && slot > lo) {
+        int mid = (lo + hi) / 2;
+        if (slot >= mid) {
+            s = combineSummary(s, lc->tree[2 * node]);
+            node = 2 * node + 1;
+            lo = mid;
+        } else {
+            node = 2 * node;
+            hi = mid;
+        }
+    }
+    return s;
+}
+
+// Document offset of a line (index == line count gives the document length)
+int getLineStart(LineCache *lc, int index) {
+    if (index >= lineCount(lc)) {
+        return lc->tree[1].length;
+    }
+    return summaryBefore(lc, lineSlot(lc, index)).length;
+}
+
+// Bracket balance at the start of a line (index == line count gives the total)
+int getBracketBalanceBefore(LineCache *lc, int index) {
+    if (index >= lineCount(lc)) {
+        return lc->tree[1].bracketSum;
+    }
+    return summaryBefore(lc, lineSlot(lc, index)).bracketSum;
+}
+
+// First leaf at or after slot 'from' where the running balance drops to target
+static int searchForward(LineCache *lc, int node, int lo, int hi, int from,
+                         int *balance, int target) {
+    LineSummary s = lc->tree[node];
+    if (hi <= from || s.lines == 0) {
+        return -1;
+    }
+    if (lo >= from && *balance + s.bracketMin > target) {
+        *balance += s.bracketSum;
+        return -1;
+    }
+    if (node >= lc->capacity) {
+        return lo;
+    }
+    int mid = (lo + hi) / 2;
+    int found = searchForward(lc, 2 * node, lo, mid, from, balance, target);
+    if (found >= 0) {
+        return found;
+    }
+    return searchForward(lc, 2 * node + 1, mid, hi, from, balance, target);
+}
+
+// Last leaf before slot 'before' where the running balance drops to target
+static int searchBackward(LineCache *lc, int node, int lo, int hi, int before,
+                          int balance, int target) {
+    LineSummary s = lc->tree[node];
+    if (lo >= before || s.lines == 0) {
+        return -1;
+    }
+    if (hi <= before && balance + s.bracketMin > target) {
+        return -1;
+    }
+    if (node >= lc->capacity) {
+        return lo;
+    }
+    int mid = (lo + hi) / 2;
+    int found = searchBackward(lc, 2 * node + 1, mid, hi, before,
+                               balance + lc->tree[2 * node].bracketSum, target);
+    if (found >= 0) {
+        return found;
+    }
+    return searchBackward(lc, 2 * node, lo, mid, before, balance, target);
+}
+
+// First line at or after fromIndex in which the running bracket balance
+// (counted from the document start) falls to target or below, or -1
+// ALGORITHM: Segment tree descent on minimum prefix balance - O(log n)
+int findBalanceLineForward(LineCache *lc, int fromIndex, int target) {
+    if (fromIndex >= lineCount(lc)) {
+        return -1;
+    }
+    int from = lineSlot(lc, fromIndex);
+    int balance = summaryBefore(lc, from).bracketSum;
+    int slot = searchForward(lc, 1, 0, lc->capacity, from, &balance, target);
+    return (slot < 0) ? -1 : slotLine(lc, slot);
+}
+
+// Last line before beforeIndex in which the running bracket balance falls to
+// target or below (its start counts), or -1
+// ALGORITHM: Segment tree descent on minimum prefix balance - O(log n)
+int findBalanceLineBackward(LineCache *lc, int beforeIndex, int target) {
+    int before = (beforeIndex >= lineCount(lc)) ? lc->capacity : lineSlot(lc, beforeIndex);
+    int slot = searchBackward(lc, 1, 0, lc->capacity, before, 0, target);
+    return (slot < 0) ? -1 : slotLine(lc, slot);
+}
+
+// Free all memory held by the cache
+void freeLineCache(LineCache *lc) {
+    for (int i = 0; i < lineCount(lc); i++) {
+        free(getCachedLine(lc, i)->tokens);
+    }
+    free(lc->lines);
+    free(lc->tree);
+    lc->lines = NULL;
+    lc->tree = NULL;
+    lc->capacity = 0;
+    lc->gapStart = 0;
+    lc->gapEnd = 0;
+    lc->hasDirty = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef LINECACHE_H
+#define LINECACHE_H
+
+#include "lexer.h"
+
+// Per-line LEXER STATE CACHE for INCREMENTAL RE-HIGHLIGHTING
+// Each line keeps the lexer state it starts in, the state it ends in and its
+// token spans; after an edit only the touched lines are re-lexed, and lexing
+// stops as soon as a line ends in the state the next line was cached with
+// The cache is only valid for one grammar; invalidate it when the grammar changes
+
+// One line of the document (text up to and including its '\n')
+typedef struct {
+    int length;                 // Characters in the line, including '\n'
+    unsigned char startState;   // Lexer state at the start of the line
+    unsigned char endState;     // Lexer state after the line
+    unsigned char dirty;        // Text changed since the line was lexed
+    Token *tokens;              // Token spans, offsets relative to the line start
+    int tokenCount;
+    int bracketSum;             // Opening minus closing brackets outside strings/comments
+    int bracketMin;             // Lowest running balance within the line (<= 0)
+} LineEntry;
+
+// Summary of a range of line slots (node of the line tree)
+typedef struct {
+    int length;       // Characters
+    int lines;        // Lines (gap slots count as none)
+    int bracketSum;   // Bracket balance change over the range
+    int bracketMin;   // Lowest running balance from the range start (<= 0)
+} LineSummary;
+
+// Line cache structure
+// DATA STRUCTURE: Gap array of lines - lines store lengths, not offsets, and the
+// gap sits at the last edited line, so consecutive edits on nearby lines cost O(1)
+// A segment tree over the array slots (gap slots are empty leaves) sums lengths
+// and bracket balances, so offset->line and bracket searches are O(log n)
+typedef struct {
+    LineEntry *lines;   // Gap array of lines in document order
+    int capacity;       // Allocated slots in lines
+    int gapStart;       // First free slot
+    int gapEnd;         // First used slot after the gap
+    int gapOffset;      // Document offset of the first line after the gap
+    int docLength;      // Document length the lines refer to
+
+    LineSummary *tree;  // Segment tree over the slots: tree[capacity + slot] is a leaf
+
+    int hasDirty;       // Some lines must be re-lexed
+    int dirtyStart;     // Dirty lines all lie in [dirtyStart, dirtyEnd)
+    int dirtyEnd;
+} LineCache;
+
+// Returns a malloc'd copy of the document text in [start, end)
+typedef char* (*LineTextFn)(void *ctx, int start, int end);
+
+// Function declarations
+void initLineCache(LineCache *lc);
+void lineCacheInvalidateAll(LineCache *lc, int docLength);
+void lineCacheNoteEdit(LineCache *lc, int pos, int inserted, int removed);
+int refreshLineCache(LineCache *lc, const Grammar *g, LineTextFn fetchText, void *ctx);
+int getCachedLineCount(LineCache *lc);
+LineEntry* getCachedLine(LineCache *lc, int index);
+int findLineAt(LineCache *lc, int pos, int *lineStart);
+int getLineStart(LineCache *lc, int index);
+int bracketDelta(unsigned char c);
+int getBracketBalanceBefore(LineCache *lc, int index);
+int findBalanceLineForward(LineCache *lc, int fromIndex, int target);
+int findBalanceLineBackward(LineCache *lc, int beforeIndex, int target);
+void freeLineCache(LineCache *lc);
+
+#endif
@@ -1,8 +1,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "editor.h"
 #include "deque.h"
+#include "analysis.h"
+#include "viewport.h"
+#include "terminal.h"
+#include "tabio.h"
+#include "search.h"
+
+#define VIEWPORT_ROWS 20   // Document lines shown above the menu
+#define SEARCH_RESULTS_SHOWN 100   // Project search stops after this many matches
 
 // Display main menu
 void displayMenu() {
@@ -12,6 +21,7 @@ void displayMenu() {
     printf("  2. Delete Character\n");
     printf("  3. Move Cursor (Left/Right/Up/Down)\n");
     printf("  4. Search Word\n");
+    printf(" 27. Search All Tabs\n");
     printf("  5. Word Count & Character Count\n");
     printf("\nINTERMEDIATE FEATURES:\n");
     printf("  6. Undo\n");
@@ -24,15 +34,19 @@ void displayMenu() {
     printf(" 13. Delete Line\n");
     printf("\nADVANCED FEATURES:\n");
     printf(" 14. Auto-save\n");
+    printf(" 28. Recover Auto-save\n");
     printf(" 15. Syntax Highlighting\n");
     printf(" 16. Spell Checker\n");
     printf(" 17. Bracket Matching\n");
+    printf(" 25. Match Bracket at Cursor\n");
     printf(" 18. Search Suggestions\n");
+    printf(" 24. Add Word to Dictionary\n");
     printf(" 19. Multiple File Tabs\n");
     printf("\nFILE OPERATIONS:\n");
     printf(" 20. Load File\n");
     printf(" 21. Save File\n");
     printf(" 22. Display Text\n");
+    printf(" 26. Full-Screen Editing Mode\n");
     printf("\nVISUALIZATION:\n");
     printf(" 23. Visualize Linked List Structure\n");
     printf("  0. Exit\n");
@@ -102,6 +116,10 @@ void handleTabs(TabDeque *tabs) {
     printf("3. Remove Tab\n");
     printf("4. Display All Tabs\n");
     printf("5. Back to Main Menu\n");
+    printf("6. Open File in New Tab\n");
+    printf("7. Open Several Files\n");
+    printf("8. Save All Modified Tabs\n");
+    printf("9. Toggle Compression of Inactive Tabs\n");
     printf("Enter choice: ");
     scanf("%d", &choice);
     getchar();
@@ -140,11 +158,127 @@ void handleTabs(TabDeque *tabs) {
             break;
         case 5:
             return;
+        case 6:
+            printf("Enter filename to open: ");
+            fgets(filename, sizeof(filename), stdin);
+            filename[strcspn(filename, "\n")] = '\0';
+            if (findTab(tabs, filename) >= 0) {
+                tabIndex = openTab(tabs, filename);
+                printf("'%s' is already open in tab %d; switched to it.\n", filename, tabIndex);
+            } else {
+                tabIndex = openTab(tabs, filename);
+                printf("Tab %d opened; the file is read when the tab is first shown.\n", tabIndex);
+            }
+            break;
+        case 7: {
+            char line[1024];
+            const char *names[64];
+            int nameCount = 0;
+            printf("Enter filenames separated by spaces: ");
+            fgets(line, sizeof(line), stdin);
+            line[strcspn(line, "\n")] = '\0';
+            for (char *name = strtok(line, " \t"); name != NULL && nameCount < 64;
+                 name = strtok(NULL, " \t")) {
+                names[nameCount++] = name;
+            }
+            int loaded = openFilesInTabs(tabs, names, nameCount);
+            printf("%d of %d files loaded.\n", loaded, nameCount);
+            break;
+        }
+        case 8:
+            printf("%d tabs saved.\n", saveAllTabs(tabs));
+            break;
+        case 9:
+            setSnapshotCompression(tabs, !tabs->compressSnapshots);
+            printf("Inactive tabs are now kept %s.\n",
+                   tabs->compressSnapshots ? "compressed" : "uncompressed");
+            break;
         default:
             printf("Invalid choice.\n");
     }
 }
 
+// Function to find the partner of the bracket at (or just before) the cursor
+void handleMatchBracket(Editor *e) {
+    int pos = e->cursorPos;
+    int partner = findMatchingBracket(e, pos);
+    if (partner < 0 && pos > 0) {
+        pos--;
+        partner = findMatchingBracket(e, pos);
+    }
+    
+    if (partner >= 0) {
+        printf("Bracket at offset %d matches bracket at offset %d.\n", pos, partner);
+    } else {
+        printf("No matching bracket at the cursor.\n");
+    }
+    
+    int unbalanced = findFirstUnbalancedBracket(e);
+    if (unbalanced >= 0) {
+        printf("First unbalanced bracket at offset %d.\n", unbalanced);
+    }
+}
+
+// Filename of the current tab ("untitled.txt" when no tab is open)
+const char* getCurrentFilename(TabDeque *tabs) {
+    Tab *tab = getTab(tabs, getCurrentTabIndex(tabs));
+    return (tab != NULL) ? tab->filename : "untitled.txt";
+}
+
+// Function to highlight the current tab with the grammar for its file extension
+void handleSyntaxHighlight(TabDeque *tabs, Editor *e) {
+    const Grammar *grammar = findGrammarForFile(getCurrentFilename(tabs));
+    if (grammar == NULL) {
+        grammar = getDefaultGrammar();
+    }
+    setEditorGrammar(e, grammar);
+    highlightSyntax(e);
+}
+
+// Print one project search match; stops the search once enough are shown
+typedef struct {
+    int shown;
+    SearchToken *token;
+} SearchPrinter;
+
+void printSearchMatch(const SearchMatch *match, void *context) {
+    SearchPrinter *printer = (SearchPrinter *)context;
+    printf("%s:%d:%d: %.*s\n", match->filename, match->line, match->column,
+           match->snippetLength, match->snippet);
+    if (++printer->shown == SEARCH_RESULTS_SHOWN) {
+        cancelSearch(printer->token);
+    }
+}
+
+// Function to search every tab (and optionally files on disk) for a word
+void handleProjectSearch(TabDeque *tabs, SearchToken *token) {
+    char word[100];
+    char line[1024];
+    const char *files[64];
+    int fileCount = 0;
+    
+    printf("Enter word to search: ");
+    fgets(word, sizeof(word), stdin);
+    word[strcspn(word, "\n")] = '\0';
+    printf("Also search files on disk (space-separated, blank for none): ");
+    fgets(line, sizeof(line), stdin);
+    line[strcspn(line, "\n")] = '\0';
+    for (char *name = strtok(line, " \t"); name != NULL && fileCount < 64;
+         name = strtok(NULL, " \t")) {
+        files[fileCount++] = name;
+    }
+    
+    SearchPrinter printer = {0, token};
+    int found = searchProject(tabs, files, fileCount, word, token, printSearchMatch, &printer);
+    if (found < 0) {
+        printf("... stopped after %d matches.\n", printer.shown);
+    } else if (found == 0) {
+        printf("Word '%s' not found.\n", word);
+    } else {
+        printf("%d matches.\n", found);
+    }
+}
+
 int main() {
     Editor editor;
     TabDeque tabs;
@@ -156,24 +290,32 @@ int main() {
     char lineText[1000];
     int lineNum;
     char prefix[100];
+    Viewport viewport;
+    SearchToken searchToken;
+    int termRows, termCols = 80;
     
     // Initialize editor
     initEditor(&editor);
     
     // Initialize tabs (Deque for multiple file tabs)
     initTabDeque(&tabs);
-    addTab(&tabs, "untitled.txt");
+    initSearchToken(&searchToken);
+    
+    // Viewport above the menu (plain frames: menu output scrolls the terminal)
+    getTerminalSize(STDOUT_FILENO, &termRows, &termCols);
+    initViewport(&viewport, VIEWPORT_ROWS, termCols, 0);
     
     printf("========== ADVANCED TEXT EDITOR ==========\n");
     printf("Welcome to the Text Editor!\n");
     printf("\nThis editor demonstrates various Data Structures:\n");
     printf("- Doubly Linked List: Text storage & cursor movement\n");
     printf("- Stack: Undo/Redo & Bracket matching\n");
+    printf("- Segment tree: Bracket index over lexed lines\n");
     printf("- Queue: Auto-save operations\n");
     printf("- Trie: Spell checker & Search suggestions\n");
     printf("- Deque: Multiple file tabs\n");
     printf("- Linked List of Strings: Line-wise editing\n");
-    printf("- Hash Table (simulated): Syntax highlighting\n");
+    printf("- DFA lexer + perfect hash: Syntax highlighting\n");
     printf("==========================================\n");
     
     // Ask if user wants to load a file
@@ -185,7 +327,9 @@ int main() {
         printf("Enter filename to load: ");
         fgets(filename, sizeof(filename), stdin);
         filename[strcspn(filename, "\n")] = '\0';
-        loadFile(&editor, filename);
+        openTab(&tabs, filename);   // Read when the tab is first shown
+    } else {
+        addTab(&tabs, "untitled.txt");
     }
     
     // Main menu loop
@@ -195,7 +339,7 @@ int main() {
             currentEditor = &editor;
         }
         
-        displayText(currentEditor);
+        renderViewport(&viewport, currentEditor);
         displayMenu();
         scanf("%d", &choice);
         getchar();  // Consume newline
@@ -224,6 +368,10 @@ int main() {
                 searchWord(currentEditor, wordToSearch);
                 break;
                 
+            case 27:  // Search All Tabs
+                handleProjectSearch(&tabs, &searchToken);
+                break;
+    
             case 5:  // Word Count & Character Count
                 printf("\n--- Statistics ---\n");
                 printf("Character Count: %d\n", getCharCount(currentEditor));
@@ -283,10 +431,13 @@ int main() {
                 autoSave(currentEditor);
                 processAutoSaveQueue(currentEditor);
                 break;
+    
+            case 28:  // Recover Auto-save
+                recoverAutoSave(currentEditor);
+                break;
                 
             case 15:  // Syntax Highlighting
-                currentEditor->syntaxHighlightEnabled = 1;
-                highlightSyntax(currentEditor);
+                handleSyntaxHighlight(&tabs, currentEditor);
                 break;
                 
             case 16:  // Spell Checker
@@ -297,6 +448,10 @@ int main() {
                 checkBracketMatching(currentEditor);
                 break;
                 
+            case 25:  // Match Bracket at Cursor
+                handleMatchBracket(currentEditor);
+                break;
+                
             case 18:  // Search Suggestions
                 printf("Enter prefix for suggestions: ");
                 fgets(prefix, sizeof(prefix), stdin);
@@ -304,6 +459,13 @@ int main() {
                 getSearchSuggestions(currentEditor, prefix);
                 break;
                 
+            case 24:  // Add Word to Dictionary
+                printf("Enter word to add: ");
+                fgets(wordToSearch, sizeof(wordToSearch), stdin);
+                wordToSearch[strcspn(wordToSearch, "\n")] = '\0';
+                addWordToDictionary(currentEditor, wordToSearch);
+                break;
+                
             case 19:  // Multiple File Tabs
                 handleTabs(&tabs);
                 currentEditor = getCurrentEditor(&tabs);
@@ -330,14 +492,22 @@ int main() {
                 displayText(currentEditor);
                 break;
                 
+            case 26:  // Full-Screen Editing Mode
+                runTerminalEditor(currentEditor, getCurrentFilename(&tabs));
+                break;
+                
             case 23:  // Visualize Linked List Structure
                 visualizeLinkedList(currentEditor);
                 break;
                 
             case 0:  // Exit
                 printf("Exiting editor...\n");
-                freeEditor(currentEditor);
                 freeTabDeque(&tabs);
+                freeEditor(&editor);
+                freeViewport(&viewport);
+                shutdownTabIOPool();
+                shutdownAnalysisPool();
+                freeGrammarRegistry();
                 printf("Thank you for using the Text Editor!\n");
                 return 0;
                 
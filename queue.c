@@ -35,7 +35,7 @@ void enqueue(Queue *q, AutoSaveOperation op) {
     
     // Allocate memory for content
     q->items[q->rear].content = (char *)malloc((op.contentLength + 1) * sizeof(char));
-    strcpy(q->items[q->rear].content, op.content);
+    memcpy(q->items[q->rear].content, op.content, op.contentLength + 1);
     q->items[q->rear].contentLength = op.contentLength;
     strcpy(q->items[q->rear].filename, op.filename);
     
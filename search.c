@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+#include "search.h"
+#include "analysis.h"
+
+// Where a match was found, with its line kept in the file's snippet arena
+typedef struct {
+    int offset;
+    int line;
+    int column;
+    int snippetStart;        // Index into the file's snippet arena
+    int snippetLength;
+} MatchRecord;
+
+// State shared by all files of one query
+typedef struct {
+    unsigned char *pattern;  // Case-folded pattern
+    int *failure;            // KMP failure function of the pattern
+    int length;
+    int newlines;            // Line breaks inside the pattern before its last character
+    SearchToken *token;
+    unsigned int generation; // Token generation this query was started with
+    pthread_mutex_t lock;    // Protects the done flags
+    pthread_cond_t fileDone; // Signalled whenever a file finishes
+} SearchQuery;
+
+// One file of the query and the matches found in it
+// DATA STRUCTURE: Growable arrays - one for the matches, one arena for the
+// snippets, so a file with many matches costs two allocations, not one each
+typedef struct {
+    SearchQuery *query;
+    const char *filename;
+    Editor *editor;          // Resident tab: the list is scanned in place
+    const TabSnapshot *snapshot;  // Evicted tab (streamed chunk by chunk if compressed)
+    const char *text;        // Flat text being scanned, if not the list
+    int textStart;           // Offset of text[0]: a window of the cold text, else 0
+    int textEnd;             // Offset just past the last byte in text
+    const ColdText *cold;    // Compressed snapshot the window is refilled from
+    int length;
+    int readFromDisk;        // Unloaded tab or file on disk: read by the worker
+    
+    MatchRecord *matches;
+    int matchCount;
+    int matchCapacity;
+    char *snippets;
+    int snippetsUsed;
+    int snippetsCapacity;
+    
+    int failed;              // File on disk or compressed snapshot could not be read
+    int done;                // Scan finished (protected by the query lock)
+} SearchFile;
+
+// Initialize a cancellation token
+void initSearchToken(SearchToken *token) {
+    atomic_init(&token->generation, 0);
+}
+
+// Cancel the query running on token, if any
+void cancelSearch(SearchToken *token) {
+    atomic_fetch_add(&token->generation, 1);
+}
+
+static int isCancelled(SearchQuery *q) {
+    return atomic_load_explicit(&q->token->generation, memory_order_relaxed) != q->generation;
+}
+
+// Append one match, copying its line (up to SEARCH_SNIPPET_LENGTH characters)
+// from either the array or the list. A line that is not all inside the current
+// window of a compressed snapshot is decoded again from the chunks it covers
+static void recordMatch(SearchFile *file, int offset, int line, int lineStart,
+                        Node *lineNode, Node *tail) {
+    if (file->matchCount == file->matchCapacity) {
+        file->matchCapacity = (file->matchCapacity == 0) ? 16 : file->matchCapacity * 2;
+        file->matches = (MatchRecord *)realloc(file->matches,
+                                               file->matchCapacity * sizeof(MatchRecord));
+    }
+    if (file->snippetsUsed + SEARCH_SNIPPET_LENGTH > file->snippetsCapacity) {
+        file->snippetsCapacity = (file->snippetsCapacity == 0) ? 1024 : file->snippetsCapacity * 2;
+        file->snippets = (char *)realloc(file->snippets, file->snippetsCapacity);
+    }
+    
+    char *snippet = file->snippets + file->snippetsUsed;
+    int n = 0;
+    const char *text = file->text;
+    int inWindow = lineStart >= file->textStart &&
+                   (lineStart + SEARCH_SNIPPET_LENGTH <= file->textEnd || file->textEnd == file->length);
+    if (text != NULL && inWindow) {
+        while (n < SEARCH_SNIPPET_LENGTH && lineStart + n < file->textEnd &&
+               text[lineStart - file->textStart + n] != '\n') {
+            snippet[n] = text[lineStart - file->textStart + n];
+            n++;
+        }
+    } else if (text != NULL) {
+        int read = readColdRange(file->cold, lineStart, SEARCH_SNIPPET_LENGTH, snippet);
+        while (n < read && snippet[n] != '\n') {
+            n++;
+        }
+    } else {
+        for (Node *node = lineNode; n < SEARCH_SNIPPET_LENGTH && node != tail &&
+             node->data != '\n'; node = node->next) {
+            snippet[n++] = node->data;
+        }
+    }
+    
+    MatchRecord *m = &file->matches[file->matchCount++];
+    m->offset = offset;
+    m->line = line + 1;
+    m->column = offset - lineStart + 1;
+    m->snippetStart = file->snippetsUsed;
+    m->snippetLength = n;
+    file->snippetsUsed += n;
+}
+
+// Worker: scan one file for the pattern (case-insensitive, overlapping matches)
+// ALGORITHM: KMP - a single pass over the text, O(n + m), reading the list
+// node by node so resident tabs are never copied, and a compressed snapshot
+// one chunk at a time through a single COLD_CHUNK_SIZE window; the starts of
+// the last few lines are kept in a ring so matches spanning line breaks know their line
+static void scanFileTask(void *arg) {
+    SearchFile *file = (SearchFile *)arg;
+    SearchQuery *q = file->query;
+    
+    char *ownedText = NULL;
+    const char *text = NULL;
+    Node *node = NULL;
+    Node *tail = NULL;
+    if (file->readFromDisk) {
+        ownedText = readTextFile(file->filename, &file->length);
+        text = ownedText;
+        file->failed = (ownedText == NULL);
+    } else if (file->snapshot != NULL) {
+        file->length = file->snapshot->length;
+        if (file->snapshot->text != NULL || file->length == 0) {
+            text = file->snapshot->text;
+        } else {
+            // The window starts empty and is filled at offset 0
+            file->cold = &(file->snapshot->cold);
+            ownedText = (char *)malloc(COLD_CHUNK_SIZE);
+            text = ownedText;
+        }
+    } else if (file->editor != NULL) {
+        node = file->editor->head;
+        tail = file->editor->tail;
+        file->length = file->editor->length;
+    }
+    file->text = text;
+    file->textStart = 0;
+    file->textEnd = (file->cold != NULL) ? 0 : file->length;
+    
+    if (!file->failed) {
+        int ringSize = q->newlines + 1;
+        int *lineStarts = (int *)malloc(ringSize * sizeof(int));
+        Node **lineNodes = (Node **)malloc(ringSize * sizeof(Node *));
+        int line = 0;
+        lineStarts[0] = 0;
+        lineNodes[0] = (node != NULL) ? node->next : NULL;
+    
+        int matched = 0;
+        for (int pos = 0; pos < file->length; pos++) {
+            if ((pos & (SEARCH_CANCEL_INTERVAL - 1)) == 0 && isCancelled(q)) {
+                break;
+            }
+    
+            char c;
+            if (node != NULL) {
+                node = node->next;
+                c = node->data;
+            } else {
+                if (pos == file->textEnd) {
+                    // Past the window: decode the next chunk into it
+                    int read = readColdRange(file->cold, pos, COLD_CHUNK_SIZE, ownedText);
+                    if (read <= 0) {
+                        printf("Error: Compressed text is corrupt\n");
+                        file->failed = 1;
+                        break;
+                    }
+                    file->textStart = pos;
+                    file->textEnd = pos + read;
+                }
+                c = text[pos - file->textStart];
+            }
+    
+            unsigned char folded = (unsigned char)tolower((unsigned char)c);
+            while (matched > 0 && q->pattern[matched] != folded) {
+                matched = q->failure[matched - 1];
+            }
+            if (q->pattern[matched] == folded) {
+                matched++;
+            }
+            if (matched == q->length) {
+                int startLine = line - q->newlines;
+                int slot = startLine % ringSize;
+                recordMatch(file, pos - q->length + 1, startLine, lineStarts[slot],
+                            lineNodes[slot], tail);
+                matched = q->failure[matched - 1];
+            }
+    
+            if (c == '\n') {
+                line++;
+                lineStarts[line % ringSize] = pos + 1;
+                lineNodes[line % ringSize] = (node != NULL) ? node->next : NULL;
+            }
+        }
+    
+        free(lineStarts);
+        free(lineNodes);
+    }
+    free(ownedText);
+    file->text = NULL;
+    
+    pthread_mutex_lock(&(q->lock));
+    file->done = 1;
+    pthread_cond_broadcast(&(q->fileDone));
+    pthread_mutex_unlock(&(q->lock));
+}
+
+// Search every tab, then every extra file not open in a tab, for pattern
+// (case-insensitive). Matches go to callback in file order, then offset order,
+// on the calling thread; a file's matches are delivered as soon as it and all
+// files before it are scanned. Returns the number of matches delivered, or -1
+// if the query was cancelled (by cancelSearch, possibly from the callback, or
+// by a newer query on the same token)
+// The tabs must not change until the call returns
+int searchProject(TabDeque *dq, const char **files, int fileCount, const char *pattern,
+                  SearchToken *token, SearchCallback callback, void *context) {
+    if (pattern == NULL || strlen(pattern) == 0) {
+        printf("Invalid search word.\n");
+        return 0;
+    }
+    
+    SearchQuery q;
+    q.length = strlen(pattern);
+    q.pattern = (unsigned char *)malloc(q.length);
+    q.failure = (int *)malloc(q.length * sizeof(int));
+    q.newlines = 0;
+    for (int i = 0; i < q.length; i++) {
+        q.pattern[i] = (unsigned char)tolower((unsigned char)pattern[i]);
+        if (pattern[i] == '\n' && i < q.length - 1) {
+            q.newlines++;
+        }
+    }
+    q.failure[0] = 0;
+    for (int i = 1, k = 0; i < q.length; i++) {
+        while (k > 0 && q.pattern[i] != q.pattern[k]) {
+            k = q.failure[k - 1];
+        }
+        if (q.pattern[i] == q.pattern[k]) {
+            k++;
+        }
+        q.failure[i] = k;
+    }
+    q.token = token;
+    q.generation = atomic_fetch_add(&token->generation, 1) + 1;  // Cancels the previous query
+    pthread_mutex_init(&(q.lock), NULL);
+    pthread_cond_init(&(q.fileDone), NULL);
+    
+    // Tabs first, in tab order, then files on disk that are not open in a tab
+    SearchFile *scans = (SearchFile *)calloc(dq->count + fileCount + 1, sizeof(SearchFile));
+    int scanCount = 0;
+    for (int i = 0; i < dq->count + fileCount; i++) {
+        SearchFile *file = &scans[scanCount];
+        file->query = &q;
+        if (i < dq->count) {
+            Tab *tab = getTab(dq, i);
+            file->filename = tab->filename;
+            if (tab->state == TAB_RESIDENT) {
+                file->editor = tab->editor;
+            } else if (tab->state == TAB_EVICTED) {
+                file->snapshot = &(tab->snapshot);
+            } else {
+                file->readFromDisk = tab->loadOnUse;  // A new empty tab has nothing to scan
+            }
+        } else {
+            if (findTab(dq, files[i - dq->count]) >= 0) {
+                continue;
+            }
+            file->filename = files[i - dq->count];
+            file->readFromDisk = 1;
+        }
+        scanCount++;
+    }
+    
+    TaskGroup group;
+    initTaskGroup(&group);
+    ThreadPool *pool = getAnalysisPool();
+    for (int i = 0; i < scanCount; i++) {
+        submitGroupTask(pool, &group, scanFileTask, &scans[i]);
+    }
+    
+    // Stream results in order while later files are still being scanned
+    int delivered = 0;
+    for (int i = 0; i < scanCount && !isCancelled(&q); i++) {
+        SearchFile *file = &scans[i];
+        pthread_mutex_lock(&(q.lock));
+        while (!file->done) {
+            pthread_cond_wait(&(q.fileDone), &(q.lock));
+        }
+        pthread_mutex_unlock(&(q.lock));
+    
+        if (file->failed) {
+            printf("Error: Cannot open file '%s'\n", file->filename);
+            continue;
+        }
+        for (int j = 0; j < file->matchCount && !isCancelled(&q); j++) {
+            MatchRecord *m = &file->matches[j];
+            SearchMatch match;
+            match.filename = file->filename;
+            match.fileIndex = i;
+            match.offset = m->offset;
+            match.line = m->line;
+            match.column = m->column;
+            match.snippet = file->snippets + m->snippetStart;
+            match.snippetLength = m->snippetLength;
+            callback(&match, context);
+            delivered++;
+        }
+    }
+    int cancelled = isCancelled(&q);
+    
+    // Workers still scanning see the cancellation (or finish) before the buffers go
+    waitTaskGroup(&group);
+    freeTaskGroup(&group);
+    for (int i = 0; i < scanCount; i++) {
+        free(scans[i].matches);
+        free(scans[i].snippets);
+    }
+    free(scans);
+    pthread_cond_destroy(&(q.fileDone));
+    pthread_mutex_destroy(&(q.lock));
+    free(q.pattern);
+    free(q.failure);
+    return cancelled ? -1 : delivered;
+}
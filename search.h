@@ -0,0 +1,42 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdatomic.h>
+#include "deque.h"
+
+// PROJECT-WIDE SEARCH across tabs and files on disk
+// Every tab (resident, evicted or not yet loaded) and every extra file is
+// scanned by its own task on the analysis thread pool. Matches are streamed
+// to a callback ordered by file, then by offset: a file's matches are
+// delivered as soon as it and all files before it have been scanned
+
+#define SEARCH_SNIPPET_LENGTH 80       // Characters of the matching line kept per match
+#define SEARCH_CANCEL_INTERVAL 65536   // Bytes scanned between cancellation checks
+
+// Cancellation token shared by successive queries
+// Starting a query on a token cancels the query that was running on it;
+// cancelSearch cancels the running query without starting a new one
+typedef struct {
+    atomic_uint generation;    // Bumped by every new query and every cancel
+} SearchToken;
+
+// One match, as handed to the callback
+typedef struct {
+    const char *filename;      // Tab filename or path on disk
+    int fileIndex;             // Position of the file in the search order
+    int offset;                // Offset of the first matching character
+    int line;                  // Line of the match (1-based)
+    int column;                // Column of the match (1-based)
+    const char *snippet;       // Start of the matching line (not null-terminated)
+    int snippetLength;         // Up to SEARCH_SNIPPET_LENGTH, stops at the line end
+} SearchMatch;
+
+typedef void (*SearchCallback)(const SearchMatch *match, void *context);
+
+// Function declarations
+void initSearchToken(SearchToken *token);
+void cancelSearch(SearchToken *token);
+int searchProject(TabDeque *dq, const char **files, int fileCount, const char *pattern,
+                  SearchToken *token, SearchCallback callback, void *context);
+
+#endif
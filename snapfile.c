@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "snapfile.h"
+#include "huffman.h"
+#include "editor.h"
+
+static unsigned int crcTable[256];
+static pthread_once_t crcTableOnce = PTHREAD_ONCE_INIT;
+
+static void buildCrcTable(void) {
+    for (unsigned int i = 0; i < 256; i++) {
+        unsigned int c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crcTable[i] = c;
+    }
+}
+
+// Continue a CRC-32 (IEEE, as in zip and PNG) over length more bytes; start with 0
+unsigned int crc32Update(unsigned int crc, const unsigned char *data, int length) {
+    pthread_once(&crcTableOnce, buildCrcTable);
+    crc = ~crc;
+    for (int i = 0; i < length; i++) {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void put32(unsigned char *p, unsigned int v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static unsigned int get32(const unsigned char *p) {
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16)
+           | ((unsigned int)p[3] << 24);
+}
+
+// Check the file header; returns the block count, or -1 if it is not a snapshot
+static int parseHeader(const unsigned char *header, int *length) {
+    if (memcmp(header, SNAPSHOT_MAGIC, 4) != 0 || header[4] != SNAPSHOT_VERSION ||
+        crc32Update(0, header, 16) != get32(header + 16)) {
+        return -1;
+    }
+    *length = (int)get32(header + 8);
+    return (int)get32(header + 12);
+}
+
+// Encode length bytes of text as a snapshot; returns a new buffer of *size bytes
+char* encodeSnapshot(const char *text, int length, int *size) {
+    int blocks = (length + SNAPSHOT_BLOCK_SIZE - 1) / SNAPSHOT_BLOCK_SIZE;
+    long capacity = SNAPSHOT_HEADER_SIZE +
+                    (long)blocks * (SNAPSHOT_FRAME_SIZE + huffman_max_compressed_size(SNAPSHOT_BLOCK_SIZE));
+    unsigned char *out = (unsigned char *)malloc(capacity);
+    
+    memcpy(out, SNAPSHOT_MAGIC, 4);
+    out[4] = SNAPSHOT_VERSION;
+    out[5] = out[6] = out[7] = 0;
+    put32(out + 8, (unsigned int)length);
+    put32(out + 12, (unsigned int)blocks);
+    put32(out + 16, crc32Update(0, out, 16));
+    
+    long used = SNAPSHOT_HEADER_SIZE;
+    for (int i = 0; i < blocks; i++) {
+        const unsigned char *block = (const unsigned char *)text + (long)i * SNAPSHOT_BLOCK_SIZE;
+        int blockLength = (length - i * SNAPSHOT_BLOCK_SIZE < SNAPSHOT_BLOCK_SIZE)
+                          ? length - i * SNAPSHOT_BLOCK_SIZE : SNAPSHOT_BLOCK_SIZE;
+        unsigned char *frame = out + used;
+        int payload = huffman_compress(block, blockLength, frame + SNAPSHOT_FRAME_SIZE,
+                                       (int)(capacity - used - SNAPSHOT_FRAME_SIZE));
+        put32(frame, (unsigned int)blockLength);
+        put32(frame + 4, (unsigned int)payload);
+        put32(frame + 8, crc32Update(0, block, blockLength));
+        used += SNAPSHOT_FRAME_SIZE + payload;
+    }
+    
+    *size = (int)used;
+    return (char *)out;
+}
+
+// Decode one block's payload into out (blockLength bytes) and check it
+// Returns 0, or -1 if the payload is damaged
+static int decodeBlock(const unsigned char *frame, const unsigned char *payload, char *out) {
+    int blockLength = (int)get32(frame);
+    int payloadSize = (int)get32(frame + 4);
+    if (huffman_decompress(payload, payloadSize, (unsigned char *)out, blockLength) != blockLength ||
+        crc32Update(0, (const unsigned char *)out, blockLength) != get32(frame + 8)) {
+        return -1;
+    }
+    return 0;
+}
+
+// Decode a snapshot; returns the text (a new buffer of *length bytes) or NULL
+// if the header is not valid. Damaged or missing blocks are left out of the
+// text and counted in *badBlocks, so everything intact is recovered
+char* decodeSnapshot(const char *data, int size, int *length, int *badBlocks) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    int textLength;
+    int blocks = (size >= SNAPSHOT_HEADER_SIZE) ? parseHeader(bytes, &textLength) : -1;
+    if (blocks < 0 || textLength < 0) {
+        return NULL;
+    }
+    
+    char *text = (char *)malloc(textLength > 0 ? textLength : 1);
+    int used = 0;
+    int bad = 0;
+    long position = SNAPSHOT_HEADER_SIZE;
+    for (int i = 0; i < blocks; i++) {
+        if (position + SNAPSHOT_FRAME_SIZE > size) {
+            bad += blocks - i;  // Truncated file: the rest is gone
+            break;
+        }
+        const unsigned char *frame = bytes + position;
+        long blockLength = get32(frame);
+        long payloadSize = get32(frame + 4);
+        if (blockLength > SNAPSHOT_BLOCK_SIZE || blockLength > textLength - used ||
+            payloadSize > size - position - SNAPSHOT_FRAME_SIZE) {
+            bad += blocks - i;  // The frame itself is damaged: later frames cannot be found
+            break;
+        }
+        if (decodeBlock(frame, frame + SNAPSHOT_FRAME_SIZE, text + used) == 0) {
+            used += (int)blockLength;
+        } else {
+            bad++;
+        }
+        position += SNAPSHOT_FRAME_SIZE + payloadSize;
+    }
+    
+    *length = used;
+    *badBlocks = bad;
+    return text;
+}
+
+// Write text to filename as a snapshot, atomically (see writeTextFile)
+// Returns the bytes written, or -1 on failure
+int writeSnapshotFile(const char *filename, const char *text, int length) {
+    int size;
+    char *data = encodeSnapshot(text, length, &size);
+    int status = writeTextFile(filename, data, size);
+    free(data);
+    return (status == 0) ? size : -1;
+}
+
+// Read a whole snapshot file (see decodeSnapshot); NULL if the file cannot be
+// read or is not a snapshot
+char* readSnapshotFile(const char *filename, int *length, int *badBlocks) {
+    int size;
+    char *data = readTextFile(filename, &size);
+    if (data == NULL) {
+        return NULL;
+    }
+    char *text = decodeSnapshot(data, size, length, badBlocks);
+    free(data);
+    return text;
+}
@@ -0,0 +1,28 @@
+#ifndef SNAPFILE_H
+#define SNAPFILE_H
+
+// COMPRESSED SNAPSHOT FILES for auto-save and recovery
+//
+// Layout (integers are 32-bit little-endian):
+//   header   "VTSN", version byte, 3 zero bytes, text length, block count,
+//            CRC-32 of the 16 bytes before it
+//   blocks   per block: text bytes, payload bytes, CRC-32 of the text bytes,
+//            then the payload (the block's text Huffman-coded, src/c/huffman.c)
+// Every block is coded on its own and carries its own sizes and checksum,
+// so a damaged block loses only its own text
+
+#define SNAPSHOT_MAGIC "VTSN"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HEADER_SIZE 20
+#define SNAPSHOT_FRAME_SIZE 12
+#define SNAPSHOT_BLOCK_SIZE 65536   // Text bytes per block (the last may be shorter)
+#define LEGACY_AUTOSAVE_FILE "autosave.txt"   // Plain-text auto-save of older builds
+
+// Function declarations
+unsigned int crc32Update(unsigned int crc, const unsigned char *data, int length);
+char* encodeSnapshot(const char *text, int length, int *size);
+char* decodeSnapshot(const char *data, int size, int *length, int *badBlocks);
+int writeSnapshotFile(const char *filename, const char *text, int length);
+char* readSnapshotFile(const char *filename, int *length, int *badBlocks);
+
+#endif
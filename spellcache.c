@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spellcache.h"
+
+#define SPELL_INITIAL_CAPACITY 16
+
+// Initialize an empty spell cache
+void initSpellCache(SpellCache *sc) {
+    sc->spans = (MisspelledWord *)malloc(SPELL_INITIAL_CAPACITY * sizeof(MisspelledWord));
+    sc->capacity = SPELL_INITIAL_CAPACITY;
+    sc->gapStart = 0;
+    sc->gapEnd = SPELL_INITIAL_CAPACITY;
+    sc->docLength = 0;
+    sc->dirtyCount = 0;
+}
+
+// Number of spans stored on each side of the gap
+static int spanCount(SpellCache *sc) {
+    return sc->gapStart + (sc->capacity - sc->gapEnd);
+}
+
+// Physical slot of the logical span index
+static int spanSlot(SpellCache *sc, int index) {
+    return (index < sc->gapStart) ? index : index + (sc->gapEnd - sc->gapStart);
+}
+
+// Absolute start offset of the span stored in a physical slot
+static int spanStart(SpellCache *sc, int slot) {
+    if (slot < sc->gapStart) {
+        return sc->spans[slot].start;
+    }
+    return sc->docLength - sc->spans[slot].start;
+}
+
+// Move the gap so that every span before it starts before pos
+// ALGORITHM: Gap buffer - cost is proportional to the spans crossed, not the document
+static void moveGap(SpellCache *sc, int pos) {
+    while (sc->gapStart > 0 && sc->spans[sc->gapStart - 1].start >= pos) {
+        MisspelledWord w = sc->spans[--sc->gapStart];
+        w.start = sc->docLength - w.start;
+        sc->spans[--sc->gapEnd] = w;
+    }
+    while (sc->gapEnd < sc->capacity && spanStart(sc, sc->gapEnd) < pos) {
+        MisspelledWord w = sc->spans[sc->gapEnd++];
+        w.start = sc->docLength - w.start;
+        sc->spans[sc->gapStart++] = w;
+    }
+}
+
+// Grow the span array, keeping the gap in place
+static void growSpans(SpellCache *sc, int needed) {
+    int newCapacity = sc->capacity;
+    while (newCapacity - spanCount(sc) < needed) {
+        newCapacity *= 2;
+    }
+    if (newCapacity == sc->capacity) {
+        return;
+    }
+
+    MisspelledWord *spans = (MisspelledWord *)malloc(newCapacity * sizeof(MisspelledWord));
+    int tail = sc->capacity - sc->gapEnd;
+    memcpy(spans, sc->spans, sc->gapStart * sizeof(MisspelledWord));
+    memcpy(spans + newCapacity - tail, sc->spans + sc->gapEnd, tail * sizeof(MisspelledWord));
+    free(sc->spans);
+
+    sc->spans = spans;
+    sc->gapEnd = newCapacity - tail;
+    sc->capacity = newCapacity;
+}
+
+// Add a dirty range, keeping the list sorted and merged
+static void addDirtyRange(SpellCache *sc, int start, int end) {
+    DirtyRange ranges[SPELL_MAX_DIRTY + 1];
+    DirtyRange merged = {start, end};
+    int out = 0;
+    int placed = 0;
+
+    for (int i = 0; i < sc->dirtyCount; i++) {
+        DirtyRange r = sc->dirty[i];
+        if (r.end < merged.start) {
+            ranges[out++] = r;
+        } else if (r.start > merged.end) {
+            if (!placed) {
+                ranges[out++] = merged;
+                placed = 1;
+            }
+            ranges[out++] = r;
+        } else {
+            // Overlapping or touching: absorb into the merged range
+            if (r.start < merged.start) merged.start = r.start;
+            if (r.end > merged.end) merged.end = r.end;
+        }
+    }
+    if (!placed) {
+        ranges[out++] = merged;
+    }
+
+    if (out > SPELL_MAX_DIRTY) {
+        // Too many scattered ranges: collapse into one bounding range
+        ranges[0].end = ranges[out - 1].end;
+        out = 1;
+    }
+    memcpy(sc->dirty, ranges, out * sizeof(DirtyRange));
+    sc->dirtyCount = out;
+}
+
+// Mark the whole document dirty and drop every cached span
+void spellCacheInvalidateAll(SpellCache *sc, int docLength) {
+    for (int i = 0; i < spanCount(sc); i++) {
+        free(sc->spans[spanSlot(sc, i)].word);
+    }
+    sc->gapStart = 0;
+    sc->gapEnd = sc->capacity;
+    sc->docLength = docLength;
+    sc->dirtyCount = 0;
+    addDirtyRange(sc, 0, docLength);
+}
+
+// Record an edit: 'removed' characters at pos replaced by 'inserted' characters
+// ALGORITHM: O(spans between the previous and the current edit point)
+void spellCacheNoteEdit(SpellCache *sc, int pos, int inserted, int removed) {
+    int delta = inserted - removed;
+
+    // Spans that started inside the removed text no longer exist
+    moveGap(sc, pos);
+    while (sc->gapEnd < sc->capacity && spanStart(sc, sc->gapEnd) < pos + removed) {
+        free(sc->spans[sc->gapEnd].word);
+        sc->gapEnd++;
+    }
+
+    // Spans after the gap are end-relative, so updating the length shifts them all
+    sc->docLength += delta;
+
+    // Shift existing dirty ranges into the new coordinates
+    for (int i = 0; i < sc->dirtyCount; i++) {
+        DirtyRange *r = &sc->dirty[i];
+        if (r->start >= pos + removed) {
+            r->start += delta;
+            r->end += delta;
+        } else if (r->end > pos) {
+            if (r->start > pos) r->start = pos;
+            r->end = (r->end > pos + removed) ? r->end + delta : pos + inserted;
+        }
+    }
+
+    addDirtyRange(sc, pos, pos + inserted);
+}
+
+// Mark [start, end) for re-checking without any edit (e.g. dictionary changed)
+void spellCacheMarkDirty(SpellCache *sc, int start, int end) {
+    addDirtyRange(sc, start, end);
+}
+
+// Check whether any range still needs re-checking
+int spellCacheHasDirty(SpellCache *sc) {
+    return sc->dirtyCount > 0;
+}
+
+// Take the first dirty range off the list
+DirtyRange spellCachePopDirty(SpellCache *sc) {
+    DirtyRange r = sc->dirty[0];
+    memmove(sc->dirty, sc->dirty + 1, (sc->dirtyCount - 1) * sizeof(DirtyRange));
+    sc->dirtyCount--;
+    return r;
+}
+
+// Replace every span starting in [start, end) with the given sorted spans
+// The cache takes ownership of each word string
+void spellCacheReplaceRange(SpellCache *sc, int start, int end,
+                            const MisspelledWord *words, int count) {
+    moveGap(sc, start);
+    while (sc->gapEnd < sc->capacity && spanStart(sc, sc->gapEnd) < end) {
+        free(sc->spans[sc->gapEnd].word);
+        sc->gapEnd++;
+    }
+
+    growSpans(sc, count);
+    for (int i = 0; i < count; i++) {
+        sc->spans[sc->gapStart++] = words[i];
+    }
+}
+
+// Number of misspelled spans currently cached
+int getMisspellingCount(SpellCache *sc) {
+    return spanCount(sc);
+}
+
+// Get a misspelled span by its index in document order
+MisspelledWord getMisspellingAt(SpellCache *sc, int index) {
+    int slot = spanSlot(sc, index);
+    MisspelledWord w = sc->spans[slot];
+    w.start = spanStart(sc, slot);
+    return w;
+}
+
+// Index of the first span starting at or after pos
+// ALGORITHM: Binary search - O(log k) where k=number of spans
+static int lowerBound(SpellCache *sc, int pos) {
+    int lo = 0;
+    int hi = spanCount(sc);
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (spanStart(sc, spanSlot(sc, mid)) < pos) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Find the misspelled span covering pos, or -1 if pos is spelled correctly
+int findMisspellingAt(SpellCache *sc, int pos) {
+    int index = lowerBound(sc, pos + 1) - 1;
+    if (index < 0) {
+        return -1;
+    }
+    MisspelledWord w = getMisspellingAt(sc, index);
+    return (pos < w.start + w.length) ? index : -1;
+}
+
+// Count the spans overlapping [start, end); firstIndex receives the first one
+int getMisspellingsInRange(SpellCache *sc, int start, int end, int *firstIndex) {
+    int first = lowerBound(sc, start);
+    if (first > 0) {
+        MisspelledWord w = getMisspellingAt(sc, first - 1);
+        if (w.start + w.length > start) {
+            first--;
+        }
+    }
+    int last = lowerBound(sc, end);
+    if (firstIndex != NULL) {
+        *firstIndex = first;
+    }
+    return last - first;
+}
+
+// Free all memory held by the cache
+void freeSpellCache(SpellCache *sc) {
+    for (int i = 0; i < spanCount(sc); i++) {
+        free(sc->spans[spanSlot(sc, i)].word);
+    }
+    free(sc->spans);
+    sc->spans = NULL;
+    sc->capacity = 0;
+    sc->gapStart = 0;
+    sc->gapEnd = 0;
+    sc->dirtyCount = 0;
+}
@@ -0,0 +1,54 @@
+#ifndef SPELLCACHE_H
+#define SPELLCACHE_H
+
+// Spell-check cache for INCREMENTAL SPELL CHECKING
+// Keeps the current set of misspelled word spans and the dirty ranges
+// produced by edits, so only words touching an edit are re-checked
+
+#define SPELL_MAX_DIRTY 64   // Dirty ranges kept before collapsing into one
+#define SPELL_MAX_WORD 100   // Longest word looked up in the dictionary
+
+// A misspelled word span
+typedef struct {
+    int start;    // Start offset (absolute before the gap, end-relative after it)
+    int length;   // Length of the word
+    char *word;   // Copy of the misspelled word
+} MisspelledWord;
+
+// Dirty range [start, end) that must be re-checked
+typedef struct {
+    int start;
+    int end;
+} DirtyRange;
+
+// Spell-check cache structure
+// DATA STRUCTURE: Gap array of sorted spans - spans before the gap store absolute
+// offsets, spans after the gap store offsets from the end of the document, so an
+// edit at the gap shifts every later span without touching it
+typedef struct {
+    MisspelledWord *spans;  // Gap array of misspelled spans, sorted by start
+    int capacity;           // Allocated slots in spans
+    int gapStart;           // First free slot
+    int gapEnd;             // First used slot after the gap
+    int docLength;          // Document length the spans refer to
+
+    DirtyRange dirty[SPELL_MAX_DIRTY]; // Sorted, non-overlapping dirty ranges
+    int dirtyCount;                    // Number of dirty ranges
+} SpellCache;
+
+// Function declarations
+void initSpellCache(SpellCache *sc);
+void spellCacheInvalidateAll(SpellCache *sc, int docLength);
+void spellCacheNoteEdit(SpellCache *sc, int pos, int inserted, int removed);
+void spellCacheMarkDirty(SpellCache *sc, int start, int end);
+int spellCacheHasDirty(SpellCache *sc);
+DirtyRange spellCachePopDirty(SpellCache *sc);
+void spellCacheReplaceRange(SpellCache *sc, int start, int end,
+                            const MisspelledWord *words, int count);
+int getMisspellingCount(SpellCache *sc);
+MisspelledWord getMisspellingAt(SpellCache *sc, int index);
+int findMisspellingAt(SpellCache *sc, int pos);
+int getMisspellingsInRange(SpellCache *sc, int start, int end, int *firstIndex);
+void freeSpellCache(SpellCache *sc);
+
+#endif
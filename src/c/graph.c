@@ -1,123 +1,952 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <emscripten/emscripten.h>
 
-#define MAX_VERTICES 20
+// Threaded BFS needs pthreads (emcc -pthread, or a native threaded build)
+#if defined(__EMSCRIPTEN_PTHREADS__) || (!defined(__EMSCRIPTEN__) && defined(_REENTRANT))
+#define GRAPH_THREADS 1
+#include <pthread.h>
+#endif
 
-typedef struct AdjNode {
-    int vertex;
-    struct AdjNode* next;
-} AdjNode;
+#define MAX_BFS_THREADS 16
+#define BFS_ALPHA 14   // Go bottom-up once frontier edges exceed unexplored edges / ALPHA
+#define BFS_BETA 24    // Back to top-down once the frontier is below vertices / BETA
 
+// Compressed sparse row (CSR) storage: the neighbors of vertex v are
+// targets[offsets[v]] .. targets[offsets[v + 1] - 1], all vertices' lists
+// back to back in one array. Neighbor i of v is a single index, and a scan
+// over a vertex (or the whole graph) is a contiguous read.
+// Edges added one at a time go to a pending edge buffer first and are merged
+// into the CSR arrays in one O(V + E) pass the next time the graph is read.
+// Edge weights, once any weighted edge is added, sit in weights[] parallel to
+// targets[]; an unweighted graph has no weights array and every edge weighs 1.
 typedef struct {
-    AdjNode* head;
-} AdjList;
+    int num_vertices;
+    
+    int* offsets;          // csr_vertices + 1 entries
+    int* targets;          // offsets[csr_vertices] entries
+    int csr_vertices;      // Vertices covered by offsets (new vertices wait for a merge)
+    int* weights;          // Parallel to targets, NULL until the graph is weighted
+    int weighted;
+    
+    int* pending_src;      // Edge buffer not yet merged into the CSR arrays
+    int* pending_dest;
+    int* pending_weights;  // Only when weighted
+    int pending_count;
+    int pending_capacity;
+    
+    int* in_offsets;       // Transposed CSR (incoming edges), built on demand
+    int* in_targets;       // by the bottom-up BFS steps; NULL when stale
+    
+    unsigned char* visited;  // vertex_capacity entries
+    int vertex_capacity;
+} Graph;
 
-AdjList graph[MAX_VERTICES];
-int num_vertices = 0;
-int visited[MAX_VERTICES];
+static void free_graph_arrays(Graph* graph) {
+    free(graph->offsets);
+    free(graph->targets);
+    free(graph->weights);
+    free(graph->pending_src);
+    free(graph->pending_dest);
+    free(graph->pending_weights);
+    free(graph->in_offsets);
+    free(graph->in_targets);
+    free(graph->visited);
+}
 
-EMSCRIPTEN_KEEPALIVE
-void graph_init(int vertices) {
-    num_vertices = vertices < MAX_VERTICES ? vertices : MAX_VERTICES;
+// Grow the vertex count to at least vertices (new vertices have no edges)
+static void ensure_vertices(Graph* graph, int vertices) {
+    if (vertices <= graph->num_vertices) return;
+    
+    if (vertices > graph->vertex_capacity) {
+        int capacity = graph->vertex_capacity == 0 ? 16 : graph->vertex_capacity;
+        while (capacity < vertices) {
+            capacity *= 2;
+        }
+        graph->visited = (unsigned char*)realloc(graph->visited, capacity);
+        graph->vertex_capacity = capacity;
+    }
+    memset(graph->visited + graph->num_vertices, 0, vertices - graph->num_vertices);
+    graph->num_vertices = vertices;
+}
+
+// Merge the pending edges (and any new vertices) into the CSR arrays
+// ALGORITHM: Counting sort by source - count degrees, prefix-sum them into
+// offsets, then copy each vertex's old neighbors followed by its new ones
+static void merge_pending(Graph* graph) {
+    int n = graph->num_vertices;
+    int* offsets = (int*)calloc(n + 1, sizeof(int));
+    
+    for (int v = 0; v < graph->csr_vertices; v++) {
+        offsets[v + 1] = graph->offsets[v + 1] - graph->offsets[v];
+    }
+    for (int i = 0; i < graph->pending_count; i++) {
+        offsets[graph->pending_src[i] + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        offsets[v + 1] += offsets[v];
+    }
     
-    for (int i = 0; i < MAX_VERTICES; i++) {
-        AdjNode* current = graph[i].head;
-        while (current != NULL) {
-            AdjNode* temp = current;
-            current = current->next;
-            free(temp);
+    int* targets = (int*)malloc((offsets[n] > 0 ? offsets[n] : 1) * sizeof(int));
+    int* weights = NULL;
+    if (graph->weighted) {
+        weights = (int*)malloc((offsets[n] > 0 ? offsets[n] : 1) * sizeof(int));
+    }
+    int* fill = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    for (int v = 0; v < n; v++) {
+        int old_degree = 0;
+        if (v < graph->csr_vertices) {
+            old_degree = graph->offsets[v + 1] - graph->offsets[v];
+            memcpy(targets + offsets[v], graph->targets + graph->offsets[v], old_degree * sizeof(int));
+            if (weights != NULL && graph->weights != NULL) {
+                memcpy(weights + offsets[v], graph->weights + graph->offsets[v], old_degree * sizeof(int));
+            } else if (weights != NULL) {
+                for (int i = 0; i < old_degree; i++) {
+                    weights[offsets[v] + i] = 1;  // Edges from before the graph was weighted
+                }
+            }
         }
-        graph[i].head = NULL;
-        visited[i] = 0;
+        fill[v] = offsets[v] + old_degree;
+    }
+    for (int i = 0; i < graph->pending_count; i++) {
+        int slot = fill[graph->pending_src[i]]++;
+        targets[slot] = graph->pending_dest[i];
+        if (weights != NULL) {
+            weights[slot] = graph->pending_weights[i];
+        }
+    }
+    free(fill);
+    
+    free(graph->offsets);
+    free(graph->targets);
+    free(graph->weights);
+    graph->offsets = offsets;
+    graph->targets = targets;
+    graph->weights = weights;
+    graph->csr_vertices = n;
+    graph->pending_count = 0;
+    
+    free(graph->in_offsets);
+    free(graph->in_targets);
+    graph->in_offsets = NULL;
+    graph->in_targets = NULL;
+}
+
+static void reserve_pending(Graph* graph, int capacity) {
+    if (capacity <= graph->pending_capacity) return;
+    
+    graph->pending_capacity = capacity;
+    graph->pending_src = (int*)realloc(graph->pending_src, capacity * sizeof(int));
+    graph->pending_dest = (int*)realloc(graph->pending_dest, capacity * sizeof(int));
+    if (graph->weighted) {
+        graph->pending_weights = (int*)realloc(graph->pending_weights, capacity * sizeof(int));
+    }
+}
+
+// Bring the CSR arrays up to date before a read
+static void ensure_csr(Graph* graph) {
+    if (graph->pending_count > 0 || graph->csr_vertices != graph->num_vertices) {
+        merge_pending(graph);
     }
 }
 
 EMSCRIPTEN_KEEPALIVE
-void graph_add_edge(int src, int dest) {
-    if (src >= num_vertices || dest >= num_vertices) return;
+void graph_init(Graph* graph, int vertices) {
+    free_graph_arrays(graph);
+    memset(graph, 0, sizeof(Graph));
+    graph->offsets = (int*)calloc(1, sizeof(int));
+    ensure_vertices(graph, vertices > 0 ? vertices : 0);
+}
+
+EMSCRIPTEN_KEEPALIVE
+Graph* graph_create(int vertices) {
+    Graph* graph = (Graph*)calloc(1, sizeof(Graph));
+    graph_init(graph, vertices);
+    return graph;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void graph_destroy(Graph* graph) {
+    free_graph_arrays(graph);
+    free(graph);
+}
+
+// Add count vertices without edges; returns the id of the first one
+EMSCRIPTEN_KEEPALIVE
+int graph_add_vertices(Graph* graph, int count) {
+    int first = graph->num_vertices;
+    if (count > 0) {
+        ensure_vertices(graph, first + count);
+    }
+    return first;
+}
+
+// Switch to weighted storage: the edges so far all weigh 1
+static void make_weighted(Graph* graph) {
+    if (graph->weighted) return;
     
-    AdjNode* newNode = (AdjNode*)malloc(sizeof(AdjNode));
-    newNode->vertex = dest;
-    newNode->next = graph[src].head;
-    graph[src].head = newNode;
+    graph->weighted = 1;
+    graph->pending_weights = (int*)malloc((graph->pending_capacity > 0 ? graph->pending_capacity : 1) * sizeof(int));
+    for (int i = 0; i < graph->pending_count; i++) {
+        graph->pending_weights[i] = 1;
+    }
+}
+
+static void push_edge(Graph* graph, int src, int dest, int weight) {
+    ensure_vertices(graph, (src > dest ? src : dest) + 1);
+    if (graph->pending_count == graph->pending_capacity) {
+        reserve_pending(graph, graph->pending_capacity == 0 ? 64 : graph->pending_capacity * 2);
+    }
+    graph->pending_src[graph->pending_count] = src;
+    graph->pending_dest[graph->pending_count] = dest;
+    if (graph->weighted) {
+        graph->pending_weights[graph->pending_count] = weight;
+    }
+    graph->pending_count++;
 }
 
+// Edges to vertices past the current count add those vertices
 EMSCRIPTEN_KEEPALIVE
-void graph_add_edge_undirected(int src, int dest) {
-    graph_add_edge(src, dest);
-    graph_add_edge(dest, src);
+void graph_add_edge(Graph* graph, int src, int dest) {
+    if (src < 0 || dest < 0) return;
+    push_edge(graph, src, dest, 1);
 }
 
+// Weights must not be negative (Dijkstra relies on it); negative ones are ignored
 EMSCRIPTEN_KEEPALIVE
-int graph_has_edge(int src, int dest) {
-    if (src >= num_vertices || dest >= num_vertices) return 0;
+void graph_add_edge_weighted(Graph* graph, int src, int dest, int weight) {
+    if (src < 0 || dest < 0 || weight < 0) return;
     
-    AdjNode* current = graph[src].head;
-    while (current != NULL) {
-        if (current->vertex == dest) {
+    make_weighted(graph);
+    push_edge(graph, src, dest, weight);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void graph_add_edge_undirected(Graph* graph, int src, int dest) {
+    graph_add_edge(graph, src, dest);
+    graph_add_edge(graph, dest, src);
+}
+
+// Append edge_count edges from two parallel arrays (merged on the next read)
+EMSCRIPTEN_KEEPALIVE
+void graph_add_edges(Graph* graph, const int* src, const int* dest, int edge_count) {
+    for (int i = 0; i < edge_count; i++) {
+        graph_add_edge(graph, src[i], dest[i]);
+    }
+}
+
+EMSCRIPTEN_KEEPALIVE
+void graph_add_edges_weighted(Graph* graph, const int* src, const int* dest, const int* weight, int edge_count) {
+    for (int i = 0; i < edge_count; i++) {
+        graph_add_edge_weighted(graph, src[i], dest[i], weight[i]);
+    }
+}
+
+// Replace the whole graph with vertices vertices and the given edges,
+// building the CSR arrays directly in O(V + E)
+EMSCRIPTEN_KEEPALIVE
+void graph_build(Graph* graph, int vertices, const int* src, const int* dest, int edge_count) {
+    graph_init(graph, vertices);
+    reserve_pending(graph, edge_count);
+    graph_add_edges(graph, src, dest, edge_count);
+    merge_pending(graph);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void graph_build_weighted(Graph* graph, int vertices, const int* src, const int* dest, const int* weight, int edge_count) {
+    graph_init(graph, vertices);
+    make_weighted(graph);
+    reserve_pending(graph, edge_count);
+    graph_add_edges_weighted(graph, src, dest, weight, edge_count);
+    merge_pending(graph);
+}
+
+// Merge buffered edges now rather than on the next read
+EMSCRIPTEN_KEEPALIVE
+void graph_commit(Graph* graph) {
+    ensure_csr(graph);
+}
+
+EMSCRIPTEN_KEEPALIVE
+int graph_has_edge(Graph* graph, int src, int dest) {
+    if (src < 0 || src >= graph->num_vertices || dest < 0 || dest >= graph->num_vertices) return 0;
+    
+    ensure_csr(graph);
+    for (int i = graph->offsets[src]; i < graph->offsets[src + 1]; i++) {
+        if (graph->targets[i] == dest) {
             return 1;
         }
-        current = current->next;
     }
     return 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int graph_get_num_vertices() {
-    return num_vertices;
+int graph_get_num_vertices(Graph* graph) {
+    return graph->num_vertices;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int graph_get_num_edges(Graph* graph) {
+    ensure_csr(graph);
+    return graph->offsets[graph->num_vertices];
 }
 
 EMSCRIPTEN_KEEPALIVE
-int graph_get_neighbor(int vertex, int position) {
-    if (vertex >= num_vertices) return -1;
+int graph_get_neighbor(Graph* graph, int vertex, int position) {
+    if (vertex < 0 || vertex >= graph->num_vertices) return -1;
     
-    AdjNode* current = graph[vertex].head;
-    for (int i = 0; i < position && current != NULL; i++) {
-        current = current->next;
+    ensure_csr(graph);
+    if (position < 0 || position >= graph->offsets[vertex + 1] - graph->offsets[vertex]) return -1;
+    return graph->targets[graph->offsets[vertex] + position];
+}
+
+EMSCRIPTEN_KEEPALIVE
+int graph_get_degree(Graph* graph, int vertex) {
+    if (vertex < 0 || vertex >= graph->num_vertices) return 0;
+    
+    ensure_csr(graph);
+    return graph->offsets[vertex + 1] - graph->offsets[vertex];
+}
+
+// Direct views of the CSR arrays for bulk reads from JS (HEAP32 at ptr >> 2);
+// valid until the graph next changes
+EMSCRIPTEN_KEEPALIVE
+int* graph_get_offsets(Graph* graph) {
+    ensure_csr(graph);
+    return graph->offsets;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int* graph_get_targets(Graph* graph) {
+    ensure_csr(graph);
+    return graph->targets;
+}
+
+// Parallel to targets; NULL for an unweighted graph (every edge weighs 1)
+EMSCRIPTEN_KEEPALIVE
+int* graph_get_weights(Graph* graph) {
+    ensure_csr(graph);
+    return graph->weights;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int graph_get_weight(Graph* graph, int vertex, int position) {
+    if (vertex < 0 || vertex >= graph->num_vertices) return -1;
+    
+    ensure_csr(graph);
+    if (position < 0 || position >= graph->offsets[vertex + 1] - graph->offsets[vertex]) return -1;
+    return graph->weights != NULL ? graph->weights[graph->offsets[vertex] + position] : 1;
+}
+
+// ===== Depth-first search =====
+
+// Visit everything reachable from source that is not yet marked visited,
+// appending vertices to order (if given) in preorder from index count;
+// returns the new count
+// ALGORITHM: Explicit stack of (vertex, next edge) pairs - the same order as
+// the recursive version, but depth is bounded by memory, not the call stack
+static int dfs_from(Graph* graph, int source, int* order, int* parent, int count) {
+    int* stack_vertex = (int*)malloc(graph->num_vertices * sizeof(int));
+    int* stack_edge = (int*)malloc(graph->num_vertices * sizeof(int));
+    int top = 0;
+    
+    graph->visited[source] = 1;
+    if (order != NULL) order[count] = source;
+    count++;
+    stack_vertex[0] = source;
+    stack_edge[0] = graph->offsets[source];
+    
+    while (top >= 0) {
+        int u = stack_vertex[top];
+        if (stack_edge[top] == graph->offsets[u + 1]) {
+            top--;
+            continue;
+        }
+        int v = graph->targets[stack_edge[top]++];
+        if (!graph->visited[v]) {
+            graph->visited[v] = 1;
+            if (order != NULL) order[count] = v;
+            if (parent != NULL) parent[v] = u;
+            count++;
+            top++;
+            stack_vertex[top] = v;
+            stack_edge[top] = graph->offsets[v];
+        }
     }
     
-    if (current != NULL) {
-        return current->vertex;
+    free(stack_vertex);
+    free(stack_edge);
+    return count;
+}
+
+// Depth-first search from source into caller buffers of num_vertices ints:
+// order receives the vertices in preorder, parent[v] the vertex v was
+// reached from (-1 for the source and unreached vertices). Either may be NULL.
+// Returns the number of vertices reached; graph_is_visited reflects the run
+EMSCRIPTEN_KEEPALIVE
+int graph_dfs(Graph* graph, int source, int* order, int* parent) {
+    if (source < 0 || source >= graph->num_vertices) return 0;
+    
+    ensure_csr(graph);
+    memset(graph->visited, 0, graph->num_vertices);
+    if (parent != NULL) {
+        for (int v = 0; v < graph->num_vertices; v++) {
+            parent[v] = -1;
+        }
     }
-    return -1;
+    return dfs_from(graph, source, order, parent, 0);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void graph_reset_visited(Graph* graph) {
+    memset(graph->visited, 0, graph->num_vertices);
 }
 
+// Mark everything reachable from vertex (keeps earlier marks)
 EMSCRIPTEN_KEEPALIVE
-int graph_get_degree(int vertex) {
-    if (vertex >= num_vertices) return 0;
+void graph_dfs_util(Graph* graph, int vertex) {
+    if (vertex < 0 || vertex >= graph->num_vertices) return;
     
-    int count = 0;
-    AdjNode* current = graph[vertex].head;
-    while (current != NULL) {
-        count++;
-        current = current->next;
+    ensure_csr(graph);
+    dfs_from(graph, vertex, NULL, NULL, 0);
+}
+
+EMSCRIPTEN_KEEPALIVE
+int graph_is_visited(Graph* graph, int vertex) {
+    if (vertex < 0 || vertex >= graph->num_vertices) return 0;
+    return graph->visited[vertex];
+}
+
+// ===== Breadth-first search =====
+
+// Build the transposed CSR arrays (who points at each vertex)
+static void ensure_in_edges(Graph* graph) {
+    ensure_csr(graph);
+    if (graph->in_offsets != NULL) return;
+    
+    int n = graph->num_vertices;
+    int edges = graph->offsets[n];
+    int* in_offsets = (int*)calloc(n + 1, sizeof(int));
+    int* in_targets = (int*)malloc((edges > 0 ? edges : 1) * sizeof(int));
+    for (int i = 0; i < edges; i++) {
+        in_offsets[graph->targets[i] + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        in_offsets[v + 1] += in_offsets[v];
+    }
+    int* fill = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    memcpy(fill, in_offsets, n * sizeof(int));
+    for (int u = 0; u < n; u++) {
+        for (int i = graph->offsets[u]; i < graph->offsets[u + 1]; i++) {
+            in_targets[fill[graph->targets[i]]++] = u;
+        }
+    }
+    free(fill);
+    graph->in_offsets = in_offsets;
+    graph->in_targets = in_targets;
+}
+
+// Direction-optimizing BFS (Beamer et al.): small frontiers expand top-down
+// (each frontier vertex pushes to its unvisited neighbors); once the frontier
+// touches a large share of the remaining edges, each unvisited vertex instead
+// looks bottom-up for any parent in the frontier and stops at the first hit,
+// skipping most edge checks on the big middle levels.
+// Visited vertices and the bottom-up frontier are bitmaps, one bit per vertex.
+// With threads, every level is split across the workers and all of them
+// meet at a barrier before the next level (level-synchronous).
+typedef struct {
+    Graph* graph;
+    int* dist;
+    int* parent;
+    int threads;
+    
+    uint64_t* visited;      // Bit per vertex
+    uint64_t* frontier_bits;  // Current frontier, for bottom-up levels
+    int* frontier;          // Current frontier as a list
+    int frontier_size;
+    int level;
+    int bottom_up;
+    int done;
+    
+    int* next[MAX_BFS_THREADS];           // Per-thread discoveries of this level
+    int next_count[MAX_BFS_THREADS];
+    long next_edges[MAX_BFS_THREADS];     // Out-degree sum of those discoveries
+#ifdef GRAPH_THREADS
+    pthread_barrier_t barrier;
+#endif
+} BfsState;
+
+static inline int test_bit(const uint64_t* bits, int v) {
+    return (int)((bits[v >> 6] >> (v & 63)) & 1);
+}
+
+static void bfs_discover(BfsState* s, int id, int v, int from) {
+    s->dist[v] = s->level + 1;
+    s->parent[v] = from;
+    s->next[id][s->next_count[id]++] = v;
+    s->next_edges[id] += s->graph->offsets[v + 1] - s->graph->offsets[v];
+}
+
+static void bfs_top_down(BfsState* s, int id) {
+    Graph* graph = s->graph;
+    int begin = (int)((long)s->frontier_size * id / s->threads);
+    int end = (int)((long)s->frontier_size * (id + 1) / s->threads);
+    
+    for (int i = begin; i < end; i++) {
+        int u = s->frontier[i];
+        for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+            int v = graph->targets[e];
+            uint64_t bit = (uint64_t)1 << (v & 63);
+            if (__atomic_load_n(&s->visited[v >> 6], __ATOMIC_RELAXED) & bit) continue;
+            if (s->threads > 1) {
+                // Several frontier vertices may reach v at once: the one that sets the bit owns it
+                if (__atomic_fetch_or(&s->visited[v >> 6], bit, __ATOMIC_RELAXED) & bit) continue;
+            } else {
+                s->visited[v >> 6] |= bit;
+            }
+            bfs_discover(s, id, v, u);
+        }
+    }
+}
+
+static void bfs_bottom_up(BfsState* s, int id) {
+    Graph* graph = s->graph;
+    int words = (graph->num_vertices + 63) >> 6;
+    // Whole bitmap words per thread, so no two threads write the same word
+    int begin = (int)((long)words * id / s->threads) << 6;
+    int end = (int)((long)words * (id + 1) / s->threads) << 6;
+    if (end > graph->num_vertices) end = graph->num_vertices;
+    
+    for (int v = begin; v < end; v++) {
+        if (test_bit(s->visited, v)) continue;
+        for (int e = graph->in_offsets[v]; e < graph->in_offsets[v + 1]; e++) {
+            int u = graph->in_targets[e];
+            if (test_bit(s->frontier_bits, u)) {
+                s->visited[v >> 6] |= (uint64_t)1 << (v & 63);
+                bfs_discover(s, id, v, u);
+                break;
+            }
+        }
+    }
+}
+
+static void bfs_level(BfsState* s, int id) {
+    s->next_count[id] = 0;
+    s->next_edges[id] = 0;
+    if (s->bottom_up) {
+        bfs_bottom_up(s, id);
+    } else {
+        bfs_top_down(s, id);
+    }
+}
+
+// Between levels (one thread): gather the next frontier and pick its direction
+static void bfs_advance(BfsState* s, long* unexplored_edges) {
+    int n = s->graph->num_vertices;
+    long frontier_edges = 0;
+    s->frontier_size = 0;
+    for (int t = 0; t < s->threads; t++) {
+        memcpy(s->frontier + s->frontier_size, s->next[t], s->next_count[t] * sizeof(int));
+        s->frontier_size += s->next_count[t];
+        frontier_edges += s->next_edges[t];
+    }
+    *unexplored_edges -= frontier_edges;
+    s->level++;
+    
+    if (s->frontier_size == 0) {
+        s->done = 1;
+        return;
+    }
+    if (!s->bottom_up && frontier_edges > *unexplored_edges / BFS_ALPHA) {
+        s->bottom_up = 1;
+    } else if (s->bottom_up && s->frontier_size < n / BFS_BETA) {
+        s->bottom_up = 0;
+    }
+    if (s->bottom_up) {
+        memset(s->frontier_bits, 0, ((n + 63) >> 6) * sizeof(uint64_t));
+        for (int i = 0; i < s->frontier_size; i++) {
+            int v = s->frontier[i];
+            s->frontier_bits[v >> 6] |= (uint64_t)1 << (v & 63);
+        }
     }
-    return count;
 }
 
+#ifdef GRAPH_THREADS
+typedef struct {
+    BfsState* state;
+    int id;
+} BfsWorker;
+
+static void* bfs_worker(void* arg) {
+    BfsWorker* worker = (BfsWorker*)arg;
+    BfsState* s = worker->state;
+    while (1) {
+        pthread_barrier_wait(&s->barrier);  // Level start (or stop)
+        if (s->done) break;
+        bfs_level(s, worker->id);
+        pthread_barrier_wait(&s->barrier);  // Level end
+    }
+    return NULL;
+}
+#endif
+
+// Breadth-first search from source into caller buffers of num_vertices ints:
+// dist[v] is the number of edges from source (-1 if unreachable) and
+// parent[v] the vertex v was reached from (-1 for the source and unreached).
+// threads > 1 splits every level across that many threads when the build has
+// thread support (otherwise it is ignored). Returns the number of vertices reached
 EMSCRIPTEN_KEEPALIVE
-void graph_reset_visited() {
-    for (int i = 0; i < num_vertices; i++) {
-        visited[i] = 0;
+int graph_bfs(Graph* graph, int source, int* dist, int* parent, int threads) {
+    int n = graph->num_vertices;
+    if (source < 0 || source >= n) return 0;
+    
+    ensure_in_edges(graph);
+#ifndef GRAPH_THREADS
+    threads = 1;
+#endif
+    if (threads < 1) threads = 1;
+    if (threads > MAX_BFS_THREADS) threads = MAX_BFS_THREADS;
+    
+    BfsState s;
+    memset(&s, 0, sizeof(BfsState));
+    s.graph = graph;
+    s.dist = dist;
+    s.parent = parent;
+    s.threads = threads;
+    int words = (n + 63) >> 6;
+    s.visited = (uint64_t*)calloc(words, sizeof(uint64_t));
+    s.frontier_bits = (uint64_t*)calloc(words, sizeof(uint64_t));
+    s.frontier = (int*)malloc(n * sizeof(int));
+    for (int t = 0; t < threads; t++) {
+        s.next[t] = (int*)malloc(n * sizeof(int));
     }
+    for (int v = 0; v < n; v++) {
+        dist[v] = -1;
+        parent[v] = -1;
+    }
+    
+    dist[source] = 0;
+    s.visited[source >> 6] |= (uint64_t)1 << (source & 63);
+    s.frontier[0] = source;
+    s.frontier_size = 1;
+    long unexplored_edges = graph->offsets[n] - (graph->offsets[source + 1] - graph->offsets[source]);
+    int reached = 1;
+    
+#ifdef GRAPH_THREADS
+    if (threads > 1) {
+        pthread_t handles[MAX_BFS_THREADS];
+        BfsWorker workers[MAX_BFS_THREADS];
+        pthread_barrier_init(&s.barrier, NULL, threads);
+        for (int t = 1; t < threads; t++) {
+            workers[t].state = &s;
+            workers[t].id = t;
+            pthread_create(&handles[t], NULL, bfs_worker, &workers[t]);
+        }
+        while (1) {
+            pthread_barrier_wait(&s.barrier);
+            if (s.done) break;
+            bfs_level(&s, 0);
+            pthread_barrier_wait(&s.barrier);
+            bfs_advance(&s, &unexplored_edges);
+            reached += s.frontier_size;
+        }
+        for (int t = 1; t < threads; t++) {
+            pthread_join(handles[t], NULL);
+        }
+        pthread_barrier_destroy(&s.barrier);
+    }
+#endif
+    while (threads == 1 && !s.done) {
+        bfs_level(&s, 0);
+        bfs_advance(&s, &unexplored_edges);
+        reached += s.frontier_size;
+    }
+    
+    for (int t = 0; t < threads; t++) {
+        free(s.next[t]);
+    }
+    free(s.visited);
+    free(s.frontier_bits);
+    free(s.frontier);
+    return reached;
 }
 
+// ===== Shortest paths =====
+
+// Radix heap of (distance, vertex) pairs for Dijkstra. Keys popped never
+// decrease, so every key shares a prefix with the last one popped; bucket b
+// holds the keys whose highest bit differing from it is bit b - 1 (bucket 0:
+// equal to it). A pop empties the lowest non-empty bucket into lower ones,
+// and each key moves down at most 32 times in total.
+#define RADIX_BUCKETS 33
+
+typedef struct {
+    unsigned int key;
+    int vertex;
+} RadixEntry;
+
+typedef struct {
+    RadixEntry* buckets[RADIX_BUCKETS];
+    int counts[RADIX_BUCKETS];
+    int capacities[RADIX_BUCKETS];
+    unsigned int last;
+    int size;
+} RadixHeap;
+
+static int radix_bucket(RadixHeap* heap, unsigned int key) {
+    return key == heap->last ? 0 : 32 - __builtin_clz(key ^ heap->last);
+}
+
+static void radix_push(RadixHeap* heap, unsigned int key, int vertex) {
+    int b = radix_bucket(heap, key);
+    if (heap->counts[b] == heap->capacities[b]) {
+        heap->capacities[b] = heap->capacities[b] == 0 ? 64 : heap->capacities[b] * 2;
+        heap->buckets[b] = (RadixEntry*)realloc(heap->buckets[b], heap->capacities[b] * sizeof(RadixEntry));
+    }
+    heap->buckets[b][heap->counts[b]].key = key;
+    heap->buckets[b][heap->counts[b]].vertex = vertex;
+    heap->counts[b]++;
+    heap->size++;
+}
+
+// Pop an entry with the smallest key (heap must not be empty)
+static RadixEntry radix_pop(RadixHeap* heap) {
+    if (heap->counts[0] == 0) {
+        int b = 1;
+        while (heap->counts[b] == 0) {
+            b++;
+        }
+        unsigned int smallest = heap->buckets[b][0].key;
+        for (int i = 1; i < heap->counts[b]; i++) {
+            if (heap->buckets[b][i].key < smallest) {
+                smallest = heap->buckets[b][i].key;
+            }
+        }
+        heap->last = smallest;
+        int count = heap->counts[b];
+        heap->counts[b] = 0;
+        heap->size -= count;
+        for (int i = 0; i < count; i++) {
+            radix_push(heap, heap->buckets[b][i].key, heap->buckets[b][i].vertex);
+        }
+    }
+    heap->size--;
+    return heap->buckets[0][--heap->counts[0]];
+}
+
+// Single-source shortest paths over non-negative weights (1 per edge when
+// unweighted) into caller buffers of num_vertices ints: dist[v] is the path
+// length (-1 if unreachable), parent[v] the previous vertex on the path (-1
+// for the source and unreachable vertices; parent may be NULL). Path lengths
+// must fit in an int. Returns the number of vertices reached
+// ALGORITHM: Dijkstra with a radix heap and lazy deletion - a vertex is
+// pushed again when its distance improves and stale entries are skipped
 EMSCRIPTEN_KEEPALIVE
-void graph_dfs_util(int vertex) {
-    visited[vertex] = 1;
+int graph_dijkstra(Graph* graph, int source, int* dist, int* parent) {
+    int n = graph->num_vertices;
+    if (source < 0 || source >= n) return 0;
     
-    AdjNode* current = graph[vertex].head;
-    while (current != NULL) {
-        if (!visited[current->vertex]) {
-            graph_dfs_util(current->vertex);
+    ensure_csr(graph);
+    for (int v = 0; v < n; v++) {
+        dist[v] = -1;
+        if (parent != NULL) parent[v] = -1;
+    }
+    memset(graph->visited, 0, n);  // Settled vertices
+    
+    RadixHeap heap;
+    memset(&heap, 0, sizeof(RadixHeap));
+    dist[source] = 0;
+    radix_push(&heap, 0, source);
+    int reached = 0;
+    
+    while (heap.size > 0) {
+        RadixEntry entry = radix_pop(&heap);
+        int u = entry.vertex;
+        if (graph->visited[u]) continue;
+        graph->visited[u] = 1;
+        reached++;
+        
+        for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+            int v = graph->targets[e];
+            unsigned int candidate = entry.key + (graph->weights != NULL ? (unsigned int)graph->weights[e] : 1);
+            if (!graph->visited[v] && (dist[v] < 0 || candidate < (unsigned int)dist[v])) {
+                dist[v] = (int)candidate;
+                if (parent != NULL) parent[v] = u;
+                radix_push(&heap, candidate, v);
+            }
         }
-        current = current->next;
     }
+    
+    for (int b = 0; b < RADIX_BUCKETS; b++) {
+        free(heap.buckets[b]);
+    }
+    return reached;
+}
+
+// ===== Connectivity =====
+
+// Union-find root with path halving
+static int find_root(int* link, int v) {
+    while (link[v] != v) {
+        link[v] = link[link[v]];
+        v = link[v];
+    }
+    return v;
 }
 
+// Connected components, ignoring edge direction: component[v] gets a label
+// 0 .. count - 1, numbered in order of each component's lowest vertex.
+// Returns the number of components
+// ALGORITHM: Union-find (union by size, path halving) over the edge array,
+// near-linear in V + E with no traversal stack
 EMSCRIPTEN_KEEPALIVE
-int graph_is_visited(int vertex) {
-    if (vertex >= num_vertices) return 0;
-    return visited[vertex];
+int graph_connected_components(Graph* graph, int* component) {
+    int n = graph->num_vertices;
+    ensure_csr(graph);
+    
+    int* link = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    int* size = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    for (int v = 0; v < n; v++) {
+        link[v] = v;
+        size[v] = 1;
+    }
+    for (int u = 0; u < n; u++) {
+        for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+            int a = find_root(link, u);
+            int b = find_root(link, graph->targets[e]);
+            if (a == b) continue;
+            if (size[a] < size[b]) {
+                int t = a;
+                a = b;
+                b = t;
+            }
+            link[b] = a;
+            size[a] += size[b];
+        }
+    }
+    
+    // Label roots in vertex order (size[] is reused as the root -> label map)
+    int count = 0;
+    for (int v = 0; v < n; v++) {
+        size[v] = -1;
+    }
+    for (int v = 0; v < n; v++) {
+        int root = find_root(link, v);
+        if (size[root] < 0) {
+            size[root] = count++;
+        }
+        component[v] = size[root];
+    }
+    
+    free(link);
+    free(size);
+    return count;
+}
+
+// Topological order of all vertices into order (num_vertices ints).
+// Returns num_vertices, or -1 if the graph has a cycle (order then holds
+// only the vertices that precede it)
+// ALGORITHM: Kahn's algorithm - repeatedly emit a vertex with no remaining
+// incoming edges; order doubles as the queue
+EMSCRIPTEN_KEEPALIVE
+int graph_topological_sort(Graph* graph, int* order) {
+    int n = graph->num_vertices;
+    ensure_csr(graph);
+    
+    int* in_degree = (int*)calloc(n > 0 ? n : 1, sizeof(int));
+    for (int e = 0; e < graph->offsets[n]; e++) {
+        in_degree[graph->targets[e]]++;
+    }
+    int tail = 0;
+    for (int v = 0; v < n; v++) {
+        if (in_degree[v] == 0) {
+            order[tail++] = v;
+        }
+    }
+    for (int head = 0; head < tail; head++) {
+        int u = order[head];
+        for (int e = graph->offsets[u]; e < graph->offsets[u + 1]; e++) {
+            if (--in_degree[graph->targets[e]] == 0) {
+                order[tail++] = graph->targets[e];
+            }
+        }
+    }
+    
+    free(in_degree);
+    return tail == n ? n : -1;
+}
+
+// Strongly connected components: component[v] gets a label 0 .. count - 1.
+// Components are numbered in reverse topological order of the condensation
+// (a component only has edges to lower-numbered ones). Returns the count
+// ALGORITHM: Tarjan's algorithm with an explicit (vertex, next edge) call
+// stack, so deep graphs cannot overflow the native stack
+EMSCRIPTEN_KEEPALIVE
+int graph_strongly_connected_components(Graph* graph, int* component) {
+    int n = graph->num_vertices;
+    ensure_csr(graph);
+    
+    int size = n > 0 ? n : 1;
+    int* index = (int*)malloc(size * sizeof(int));      // Discovery order, -1 = unvisited
+    int* lowlink = (int*)malloc(size * sizeof(int));
+    int* call_vertex = (int*)malloc(size * sizeof(int));
+    int* call_edge = (int*)malloc(size * sizeof(int));
+    int* scc_stack = (int*)malloc(size * sizeof(int));  // Vertices not yet assigned
+    for (int v = 0; v < n; v++) {
+        index[v] = -1;
+        component[v] = -1;
+    }
+    
+    int next_index = 0;
+    int count = 0;
+    int scc_top = 0;
+    for (int root = 0; root < n; root++) {
+        if (index[root] >= 0) continue;
+        
+        int top = 0;
+        call_vertex[0] = root;
+        call_edge[0] = graph->offsets[root];
+        index[root] = lowlink[root] = next_index++;
+        scc_stack[scc_top++] = root;
+        
+        while (top >= 0) {
+            int u = call_vertex[top];
+            if (call_edge[top] < graph->offsets[u + 1]) {
+                int v = graph->targets[call_edge[top]++];
+                if (index[v] < 0) {
+                    index[v] = lowlink[v] = next_index++;
+                    scc_stack[scc_top++] = v;
+                    top++;
+                    call_vertex[top] = v;
+                    call_edge[top] = graph->offsets[v];
+                } else if (component[v] < 0 && index[v] < lowlink[u]) {
+                    lowlink[u] = index[v];  // v is still on the SCC stack
+                }
+                continue;
+            }
+            
+            // u is finished: pop its component if it is the root of one
+            if (lowlink[u] == index[u]) {
+                int v;
+                do {
+                    v = scc_stack[--scc_top];
+                    component[v] = count;
+                } while (v != u);
+                count++;
+            }
+            top--;
+            if (top >= 0 && lowlink[u] < lowlink[call_vertex[top]]) {
+                lowlink[call_vertex[top]] = lowlink[u];
+            }
+        }
+    }
+    
+    free(index);
+    free(lowlink);
+    free(call_vertex);
+    free(call_edge);
+    free(scc_stack);
+    return count;
 }
@@ -2,138 +2,496 @@
 #include <stdlib.h>
 #include <string.h>
 #include <emscripten/emscripten.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
-#define TABLE_SIZE 10
+#define INITIAL_CAPACITY 16
+#define MAX_LOAD_PERCENT 85
 
-typedef struct Entry {
+// Robin Hood open addressing: entries live inline in one array. Each slot
+// records how far it sits from its home slot (0 = empty), and an insert
+// takes the slot of any entry closer to home than itself, so probe lengths
+// stay short and even. Deletion shifts the following run back by one
+// instead of leaving tombstones.
+typedef struct {
     int key;
     int value;
-    struct Entry* next;
-} Entry;
+    int distance;  // Probe distance + 1, 0 if the slot is empty
+} Slot;
 
-Entry* table[TABLE_SIZE];
+typedef struct {
+    Slot* table;
+    int capacity;  // Always a power of two
+    int count;
+} HashMap;
 
-EMSCRIPTEN_KEEPALIVE
-int hash_function(int key) {
-    return abs(key) % TABLE_SIZE;
+// Integer finalizer from MurmurHash3: every key bit affects every hash bit
+static unsigned int mix(unsigned int h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
 }
 
 EMSCRIPTEN_KEEPALIVE
-void hashmap_init() {
-    for (int i = 0; i < TABLE_SIZE; i++) {
-        Entry* current = table[i];
-        while (current != NULL) {
-            Entry* temp = current;
-            current = current->next;
-            free(temp);
+int hash_function(HashMap* map, int key) {
+    return (int)(mix((unsigned int)key) & (unsigned int)(map->capacity - 1));
+}
+
+static void allocate_table(HashMap* map, int new_capacity) {
+    map->table = (Slot*)calloc(new_capacity, sizeof(Slot));
+    map->capacity = new_capacity;
+    map->count = 0;
+}
+
+static void place(HashMap* map, int key, int value) {
+    int index = hash_function(map, key);
+    Slot entry = { key, value, 1 };
+    
+    while (1) {
+        Slot* slot = &map->table[index];
+        if (slot->distance == 0) {
+            *slot = entry;
+            map->count++;
+            return;
+        }
+        // Only the original key can already be present: once it has been
+        // swapped out, every later probe carries a displaced entry
+        if (slot->key == entry.key && slot->distance == entry.distance) {
+            slot->value = entry.value;
+            return;
         }
-        table[i] = NULL;
+        if (slot->distance < entry.distance) {
+            Slot displaced = *slot;
+            *slot = entry;
+            entry = displaced;
+        }
+        entry.distance++;
+        index = (index + 1) & (map->capacity - 1);
     }
 }
 
-EMSCRIPTEN_KEEPALIVE
-void hashmap_insert(int key, int value) {
-    int index = hash_function(key);
-    Entry* newEntry = (Entry*)malloc(sizeof(Entry));
-    newEntry->key = key;
-    newEntry->value = value;
-    newEntry->next = NULL;
+static void grow(HashMap* map) {
+    Slot* old_table = map->table;
+    int old_capacity = map->capacity;
     
-    if (table[index] == NULL) {
-        table[index] = newEntry;
-    } else {
-        // Check if key exists, update if found
-        Entry* current = table[index];
-        while (current != NULL) {
-            if (current->key == key) {
-                current->value = value;
-                free(newEntry);
-                return;
-            }
-            if (current->next == NULL) {
-                current->next = newEntry;
-                return;
-            }
-            current = current->next;
+    allocate_table(map, old_capacity * 2);
+    for (int i = 0; i < old_capacity; i++) {
+        if (old_table[i].distance != 0) {
+            place(map, old_table[i].key, old_table[i].value);
+        }
+    }
+    free(old_table);
+}
+
+static int find_slot(HashMap* map, int key) {
+    int index = hash_function(map, key);
+    // An entry closer to home than our probe length means the key is absent
+    for (int distance = 1; map->table[index].distance >= distance; distance++) {
+        if (map->table[index].key == key) {
+            return index;
         }
+        index = (index + 1) & (map->capacity - 1);
     }
+    return -1;
 }
 
+// Each map is its own instance: JS holds the pointer returned by
+// hashmap_create and passes it to every call
 EMSCRIPTEN_KEEPALIVE
-int hashmap_get(int key) {
-    int index = hash_function(key);
-    Entry* current = table[index];
+HashMap* hashmap_create() {
+    HashMap* map = (HashMap*)malloc(sizeof(HashMap));
+    allocate_table(map, INITIAL_CAPACITY);
+    return map;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void hashmap_destroy(HashMap* map) {
+    free(map->table);
+    free(map);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void hashmap_init(HashMap* map) {
+    free(map->table);
+    allocate_table(map, INITIAL_CAPACITY);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void hashmap_insert(HashMap* map, int key, int value) {
+    if ((long)(map->count + 1) * 100 > (long)map->capacity * MAX_LOAD_PERCENT) {
+        grow(map);
+    }
+    place(map, key, value);
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hashmap_get(HashMap* map, int key) {
+    int index = find_slot(map, key);
+    if (index < 0) {
+        return -1; // Not found
+    }
+    return map->table[index].value;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hashmap_delete(HashMap* map, int key) {
+    int index = find_slot(map, key);
+    if (index < 0) return 0;
     
-    while (current != NULL) {
-        if (current->key == key) {
-            return current->value;
-        }
-        current = current->next;
+    // Backward shift: pull each following entry that is away from home one
+    // slot closer, until an empty slot or an entry already at home
+    int next = (index + 1) & (map->capacity - 1);
+    while (map->table[next].distance > 1) {
+        map->table[index] = map->table[next];
+        map->table[index].distance--;
+        index = next;
+        next = (next + 1) & (map->capacity - 1);
     }
-    return -1; // Not found
+    map->table[index].distance = 0;
+    map->count--;
+    return 1;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hashmap_size(HashMap* map) {
+    return map->count;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hashmap_capacity(HashMap* map) {
+    return map->capacity;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hashmap_get_probe_distance(HashMap* map, int slot) {
+    if (slot < 0 || slot >= map->capacity || map->table[slot].distance == 0) return -1;
+    return map->table[slot].distance - 1;
+}
+
+// A bucket is a single slot now: it holds at most one entry, at position 0
+EMSCRIPTEN_KEEPALIVE
+int hashmap_get_bucket_key(HashMap* map, int bucket, int position) {
+    if (bucket < 0 || bucket >= map->capacity || position != 0) return -1;
+    if (map->table[bucket].distance == 0) return -1;
+    return map->table[bucket].key;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hashmap_get_bucket_value(HashMap* map, int bucket, int position) {
+    if (bucket < 0 || bucket >= map->capacity || position != 0) return -1;
+    if (map->table[bucket].distance == 0) return -1;
+    return map->table[bucket].value;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int hashmap_delete(int key) {
-    int index = hash_function(key);
-    Entry* current = table[index];
-    Entry* prev = NULL;
+int hashmap_get_bucket_size(HashMap* map, int bucket) {
+    if (bucket < 0 || bucket >= map->capacity) return 0;
+    return map->table[bucket].distance != 0 ? 1 : 0;
+}
+
+// ===== String-keyed map (Swiss table) =====
+// Keys are byte strings (length given, may contain zeros), values are ints.
+// One control byte per slot: EMPTY, DELETED, or the low 7 bits of the key's
+// hash. Probing loads 16 control bytes at once and compares them all against
+// those 7 bits in a single SSE2 instruction, so a key is only compared in the
+// rare slots whose bits match. Slots hold an offset into a key arena rather
+// than a pointer per key; the arena is compacted on every rehash.
+
+#define GROUP_WIDTH 16
+#define CTRL_EMPTY ((signed char)-128)
+#define CTRL_DELETED ((signed char)-2)
+
+typedef struct {
+    unsigned int key_offset;  // Into key_arena
+    unsigned int key_length;
+    int value;
+} StrSlot;
+
+typedef struct {
+    signed char* ctrl;         // capacity + GROUP_WIDTH bytes; the tail clones the first group
+    StrSlot* slots;
+    int capacity;              // Power of two, at least GROUP_WIDTH
+    int size;
+    int growth_left;           // Empty slots that may still be filled before a rehash
     
-    while (current != NULL) {
-        if (current->key == key) {
-            if (prev == NULL) {
-                table[index] = current->next;
-            } else {
-                prev->next = current->next;
+    char* arena;               // Key bytes, addressed by offset
+    unsigned int arena_used;
+    unsigned int arena_capacity;
+} StrHashMap;
+
+#ifdef __SSE2__
+// Bit i set where ctrl[i] == c
+static inline unsigned int group_match(const signed char* ctrl, signed char c) {
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(c)));
+}
+
+// Bit i set where ctrl[i] is EMPTY or DELETED (the only values with the sign bit set)
+static inline unsigned int group_match_free(const signed char* ctrl) {
+    return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+}
+#else
+static inline unsigned int group_match(const signed char* ctrl, signed char c) {
+    unsigned int mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++) {
+        mask |= (unsigned int)(ctrl[i] == c) << i;
+    }
+    return mask;
+}
+
+static inline unsigned int group_match_free(const signed char* ctrl) {
+    unsigned int mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++) {
+        mask |= (unsigned int)(ctrl[i] < 0) << i;
+    }
+    return mask;
+}
+#endif
+
+// FNV-1a over the bytes, finished with the MurmurHash3 64-bit mixer so both
+// the low 7 bits and the slot bits are well spread
+static unsigned long long hash_bytes(const char* key, int length) {
+    unsigned long long h = 14695981039346656037ull;
+    for (int i = 0; i < length; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 1099511628211ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+static void set_ctrl(StrHashMap* map, int index, signed char c) {
+    map->ctrl[index] = c;
+    map->ctrl[((index - GROUP_WIDTH) & (map->capacity - 1)) + GROUP_WIDTH] = c;
+}
+
+static unsigned int arena_store(StrHashMap* map, const char* key, int length) {
+    if (map->arena_used + length > map->arena_capacity) {
+        map->arena_capacity = map->arena_capacity == 0 ? 4096 : map->arena_capacity;
+        while (map->arena_used + length > map->arena_capacity) {
+            map->arena_capacity *= 2;
+        }
+        map->arena = (char*)realloc(map->arena, map->arena_capacity);
+    }
+    memcpy(map->arena + map->arena_used, key, length);
+    map->arena_used += length;
+    return map->arena_used - length;
+}
+
+static void allocate_str_table(StrHashMap* map, int new_capacity) {
+    map->ctrl = (signed char*)malloc(new_capacity + GROUP_WIDTH);
+    memset(map->ctrl, CTRL_EMPTY, new_capacity + GROUP_WIDTH);
+    map->slots = (StrSlot*)malloc(new_capacity * sizeof(StrSlot));
+    map->capacity = new_capacity;
+    map->size = 0;
+    map->growth_left = new_capacity - new_capacity / 8;  // Max load 7/8
+}
+
+// Index of key, or -1
+// Groups are visited in triangular order, which covers every group once
+static int str_find(StrHashMap* map, const char* key, int length, unsigned long long hash) {
+    int mask = map->capacity - 1;
+    int pos = (int)(hash >> 7) & mask;
+    signed char h2 = (signed char)(hash & 0x7F);
+    for (int step = GROUP_WIDTH; ; step += GROUP_WIDTH) {
+        unsigned int match = group_match(map->ctrl + pos, h2);
+        while (match != 0) {
+            int index = (pos + __builtin_ctz(match)) & mask;
+            StrSlot* slot = &map->slots[index];
+            if (slot->key_length == (unsigned int)length &&
+                memcmp(map->arena + slot->key_offset, key, length) == 0) {
+                return index;
             }
-            free(current);
-            return 1;
+            match &= match - 1;
         }
-        prev = current;
-        current = current->next;
+        if (group_match(map->ctrl + pos, CTRL_EMPTY) != 0) {
+            return -1;
+        }
+        pos = (pos + step) & mask;
     }
-    return 0;
 }
 
-EMSCRIPTEN_KEEPALIVE
-int hashmap_get_bucket_key(int bucket, int position) {
-    if (bucket >= TABLE_SIZE) return -1;
-    
-    Entry* current = table[bucket];
-    for (int i = 0; i < position && current != NULL; i++) {
-        current = current->next;
+// First EMPTY or DELETED slot on the key's probe sequence
+static int str_find_free(StrHashMap* map, unsigned long long hash) {
+    int mask = map->capacity - 1;
+    int pos = (int)(hash >> 7) & mask;
+    for (int step = GROUP_WIDTH; ; step += GROUP_WIDTH) {
+        unsigned int free_slots = group_match_free(map->ctrl + pos);
+        if (free_slots != 0) {
+            return (pos + __builtin_ctz(free_slots)) & mask;
+        }
+        pos = (pos + step) & mask;
     }
+}
+
+static void str_place(StrHashMap* map, const char* key, int length, int value, unsigned long long hash) {
+    int index = str_find_free(map, hash);
+    if (map->ctrl[index] == CTRL_EMPTY) {
+        map->growth_left--;
+    }
+    set_ctrl(map, index, (signed char)(hash & 0x7F));
+    map->slots[index].key_offset = arena_store(map, key, length);
+    map->slots[index].key_length = length;
+    map->slots[index].value = value;
+    map->size++;
+}
+
+// Rebuild into a table twice as large, or the same size when most of the
+// used slots are tombstones; live keys are copied into a fresh, compact arena
+static void str_rehash(StrHashMap* map) {
+    signed char* old_ctrl = map->ctrl;
+    StrSlot* old_slots = map->slots;
+    int old_capacity = map->capacity;
+    char* old_arena = map->arena;
+    
+    int new_capacity = (map->size + 1) * 16 > old_capacity * 7 ? old_capacity * 2 : old_capacity;
+    map->arena = NULL;
+    map->arena_used = 0;
+    map->arena_capacity = 0;
+    allocate_str_table(map, new_capacity);
     
-    if (current != NULL) {
-        return current->key;
+    for (int i = 0; i < old_capacity; i++) {
+        if (old_ctrl[i] >= 0) {
+            const char* key = old_arena + old_slots[i].key_offset;
+            int length = old_slots[i].key_length;
+            str_place(map, key, length, old_slots[i].value, hash_bytes(key, length));
+        }
     }
-    return -1;
+    free(old_ctrl);
+    free(old_slots);
+    free(old_arena);
 }
 
 EMSCRIPTEN_KEEPALIVE
-int hashmap_get_bucket_value(int bucket, int position) {
-    if (bucket >= TABLE_SIZE) return -1;
-    
-    Entry* current = table[bucket];
-    for (int i = 0; i < position && current != NULL; i++) {
-        current = current->next;
+StrHashMap* hashmap_str_create() {
+    StrHashMap* map = (StrHashMap*)malloc(sizeof(StrHashMap));
+    map->arena = NULL;
+    map->arena_used = 0;
+    map->arena_capacity = 0;
+    allocate_str_table(map, GROUP_WIDTH);
+    return map;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void hashmap_str_destroy(StrHashMap* map) {
+    free(map->ctrl);
+    free(map->slots);
+    free(map->arena);
+    free(map);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void hashmap_str_init(StrHashMap* map) {
+    free(map->ctrl);
+    free(map->slots);
+    free(map->arena);
+    map->arena = NULL;
+    map->arena_used = 0;
+    map->arena_capacity = 0;
+    allocate_str_table(map, GROUP_WIDTH);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void hashmap_str_insert(StrHashMap* map, const char* key, int length, int value) {
+    unsigned long long hash = hash_bytes(key, length);
+    int index = str_find(map, key, length, hash);
+    if (index >= 0) {
+        map->slots[index].value = value;
+        return;
     }
-    
-    if (current != NULL) {
-        return current->value;
+    if (map->growth_left == 0) {
+        str_rehash(map);
     }
-    return -1;
+    str_place(map, key, length, value, hash);
+}
+
+// Add delta to the value of key (a missing key starts at 0); returns the new value
+EMSCRIPTEN_KEEPALIVE
+int hashmap_str_add(StrHashMap* map, const char* key, int length, int delta) {
+    unsigned long long hash = hash_bytes(key, length);
+    int index = str_find(map, key, length, hash);
+    if (index >= 0) {
+        map->slots[index].value += delta;
+        return map->slots[index].value;
+    }
+    if (map->growth_left == 0) {
+        str_rehash(map);
+    }
+    str_place(map, key, length, delta, hash);
+    return delta;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hashmap_str_get(StrHashMap* map, const char* key, int length) {
+    int index = str_find(map, key, length, hash_bytes(key, length));
+    if (index < 0) {
+        return -1; // Not found
+    }
+    return map->slots[index].value;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int hashmap_get_bucket_size(int bucket) {
-    if (bucket >= TABLE_SIZE) return 0;
+int hashmap_str_delete(StrHashMap* map, const char* key, int length) {
+    int index = str_find(map, key, length, hash_bytes(key, length));
+    if (index < 0) return 0;
     
-    int count = 0;
-    Entry* current = table[bucket];
-    while (current != NULL) {
-        count++;
-        current = current->next;
+    // A slot may go straight back to EMPTY if no group-wide window around it
+    // was ever full, since then no probe sequence ever continued past it;
+    // otherwise it becomes a tombstone
+    int mask = map->capacity - 1;
+    unsigned int empty_before = group_match(map->ctrl + ((index - GROUP_WIDTH) & mask), CTRL_EMPTY);
+    unsigned int empty_after = group_match(map->ctrl + index, CTRL_EMPTY);
+    int never_full = empty_before != 0 && empty_after != 0 &&
+                     __builtin_ctz(empty_after) + (__builtin_clz(empty_before) - (32 - GROUP_WIDTH)) < GROUP_WIDTH;
+    if (never_full) {
+        set_ctrl(map, index, CTRL_EMPTY);
+        map->growth_left++;
+    } else {
+        set_ctrl(map, index, CTRL_DELETED);
+    }
+    map->size--;
+    return 1;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hashmap_str_size(StrHashMap* map) {
+    return map->size;
+}
+
+// Iteration: for (i = hashmap_str_next(0); i >= 0; i = hashmap_str_next(i + 1))
+// Returns the first occupied slot at or after from, or -1
+EMSCRIPTEN_KEEPALIVE
+int hashmap_str_next(StrHashMap* map, int from) {
+    for (int i = from < 0 ? 0 : from; i < map->capacity; i++) {
+        if (map->ctrl[i] >= 0) {
+            return i;
+        }
     }
-    return count;
+    return -1;
+}
+
+EMSCRIPTEN_KEEPALIVE
+const char* hashmap_str_key_at(StrHashMap* map, int slot) {
+    if (slot < 0 || slot >= map->capacity || map->ctrl[slot] < 0) return NULL;
+    return map->arena + map->slots[slot].key_offset;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hashmap_str_key_length_at(StrHashMap* map, int slot) {
+    if (slot < 0 || slot >= map->capacity || map->ctrl[slot] < 0) return -1;
+    return map->slots[slot].key_length;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int hashmap_str_value_at(StrHashMap* map, int slot) {
+    if (slot < 0 || slot >= map->capacity || map->ctrl[slot] < 0) return -1;
+    return map->slots[slot].value;
 }
@@ -1,210 +1,422 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-#define MAX_TREE_HT 100
-
-// A Huffman tree node
-struct MinHeapNode {
-    char data;
-    unsigned freq;
-    struct MinHeapNode *left, *right;
-};
-
-// A Min Heap:  Collection of
-// min-heap (or Huffman tree) nodes
-struct MinHeap {
-    unsigned size;
-    unsigned capacity;
-    struct MinHeapNode** array;
-};
-
-// A utility function allocate a new
-// min heap node with given character
-// and frequency of the character
-struct MinHeapNode* newNode(char data, unsigned freq) {
-    struct MinHeapNode* temp = (struct MinHeapNode*)malloc(sizeof(struct MinHeapNode));
-    temp->left = temp->right = NULL;
-    temp->data = data;
-    temp->freq = freq;
-    return temp;
+#include <stdint.h>
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#else
+#define EMSCRIPTEN_KEEPALIVE  // Also linked into the native editor (see huffman.h)
+#endif
+
+// Byte-oriented Huffman codec for editor buffers.
+//
+// Compressed layout (little-endian):
+//   byte 0      mode: HUFFMAN_MODE_RAW (bytes stored as is) or HUFFMAN_MODE_CODED
+//   bytes 1-4   uncompressed length
+//   coded only: 128 bytes of code lengths, two 4-bit lengths per byte (symbol
+//               2i in the low nibble), then the bit stream
+// Codes are canonical and limited to HUFFMAN_MAX_CODE_LENGTH bits, so the
+// lengths alone describe them. Bits are packed least significant first and
+// every code is stored bit-reversed, so the decoder can index a table with
+// the next HUFFMAN_MAX_CODE_LENGTH bits of the stream as they are.
+
+#define HUFFMAN_SYMBOLS 256
+#define HUFFMAN_MAX_CODE_LENGTH 12
+#define HUFFMAN_TABLE_SIZE (1 << HUFFMAN_MAX_CODE_LENGTH)
+#define HUFFMAN_MODE_RAW 0
+#define HUFFMAN_MODE_CODED 1
+#define HUFFMAN_HEADER_SIZE 5
+#define HUFFMAN_LENGTHS_SIZE (HUFFMAN_SYMBOLS / 2)
+#define HUFFMAN_SLACK 8  // Output bytes the encoder may write past the end of the stream
+
+// A tree node while computing code lengths: leaves first, then internal nodes
+typedef struct {
+    uint32_t weight;
+    int parent;
+} HuffmanNode;
+
+static uint64_t load64(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);  // Little-endian hosts (x86, wasm)
+    return v;
 }
 
-// A utility function to create
-// a min heap of given capacity
-struct MinHeap* createMinHeap(unsigned capacity) {
-    struct MinHeap* minHeap = (struct MinHeap*)malloc(sizeof(struct MinHeap));
-    minHeap->size = 0;
-    minHeap->capacity = capacity;
-    minHeap->array = (struct MinHeapNode**)malloc(minHeap->capacity * sizeof(struct MinHeapNode*));
-    return minHeap;
+static void store32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
 }
 
-// A utility function to swap
-// two min heap nodes
-void swapMinHeapNode(struct MinHeapNode** a, struct MinHeapNode** b) {
-    struct MinHeapNode* t = *a;
-    *a = *b;
-    *b = t;
+static uint32_t load32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
 }
 
-// The standard minHeapify function.
-void minHeapify(struct MinHeap* minHeap, int idx) {
-    int smallest = idx;
-    int left = 2 * idx + 1;
-    int right = 2 * idx + 2;
-
-    if (left < minHeap->size && minHeap->array[left]->freq < minHeap->array[smallest]->freq)
-        smallest = left;
-
-    if (right < minHeap->size && minHeap->array[right]->freq < minHeap->array[smallest]->freq)
-        smallest = right;
-
-    if (smallest != idx) {
-        swapMinHeapNode(&minHeap->array[smallest], &minHeap->array[idx]);
-        minHeapify(minHeap, smallest);
+// ===== Frequencies and code lengths =====
+
+// Count how often each byte value occurs into freq[256]
+// Four tables updated in turn keep runs of the same byte from stalling on a
+// single counter
+EMSCRIPTEN_KEEPALIVE
+void huffman_count_frequencies(const unsigned char* input, int length, uint32_t* freq) {
+    uint32_t counts[4][HUFFMAN_SYMBOLS];
+    memset(counts, 0, sizeof(counts));
+    
+    int i = 0;
+    for (; i + 4 <= length; i += 4) {
+        counts[0][input[i]]++;
+        counts[1][input[i + 1]]++;
+        counts[2][input[i + 2]]++;
+        counts[3][input[i + 3]]++;
+    }
+    for (; i < length; i++) {
+        counts[0][input[i]]++;
+    }
+    for (int s = 0; s < HUFFMAN_SYMBOLS; s++) {
+        freq[s] = counts[0][s] + counts[1][s] + counts[2][s] + counts[3][s];
     }
 }
 
-// A utility function to check
-// if size of heap is 1 or not
-int isSizeOne(struct MinHeap* minHeap) {
-    return (minHeap->size == 1);
-}
-
-// A standard function to extract
-// minimum value node from heap
-struct MinHeapNode* extractMin(struct MinHeap* minHeap) {
-    struct MinHeapNode* temp = minHeap->array[0];
-    minHeap->array[0] = minHeap->array[minHeap->size - 1];
-    --minHeap->size;
-    minHeapify(minHeap, 0);
-    return temp;
+static int compare_by_weight(const void* a, const void* b) {
+    const uint32_t* x = (const uint32_t*)a;
+    const uint32_t* y = (const uint32_t*)b;
+    if (x[0] != y[0]) return x[0] < y[0] ? -1 : 1;
+    return x[1] < y[1] ? -1 : (x[1] > y[1]);
 }
 
-// A utility function to insert
-// a new node to Min Heap
-void insertMinHeap(struct MinHeap* minHeap, struct MinHeapNode* minHeapNode) {
-    ++minHeap->size;
-    int i = minHeap->size - 1;
-
-    while (i && minHeapNode->freq < minHeap->array[(i - 1) / 2]->freq) {
-        minHeap->array[i] = minHeap->array[(i - 1) / 2];
-        i = (i - 1) / 2;
+// Code lengths for freq[256] into lengths[256] (0 for unused symbols), no
+// longer than max_length bits (at most HUFFMAN_MAX_CODE_LENGTH; raised to
+// ceil(log2(n)) when n used symbols cannot fit in fewer). A lone symbol gets
+// a 1-bit code. Returns the number of symbols used
+// ALGORITHM: Two-queue Huffman over the symbols sorted by weight - leaves and
+// internal nodes are both consumed in increasing weight order, so the
+// smallest two are always at the queue fronts. Codes over the limit are
+// then cut to max_length and the shortest codes among the rarest symbols
+// lengthened until the Kraft sum fits again
+EMSCRIPTEN_KEEPALIVE
+int huffman_build_code_lengths(const uint32_t* freq, unsigned char* lengths, int max_length) {
+    if (max_length < 1 || max_length > HUFFMAN_MAX_CODE_LENGTH) {
+        max_length = HUFFMAN_MAX_CODE_LENGTH;
     }
-
-    minHeap->array[i] = minHeapNode;
+    
+    uint32_t sorted[HUFFMAN_SYMBOLS][2];  // (weight, symbol), rarest first
+    int n = 0;
+    for (int s = 0; s < HUFFMAN_SYMBOLS; s++) {
+        lengths[s] = 0;
+        if (freq[s] > 0) {
+            sorted[n][0] = freq[s];
+            sorted[n][1] = s;
+            n++;
+        }
+    }
+    if (n == 0) return 0;
+    if (n == 1) {
+        lengths[sorted[0][1]] = 1;
+        return 1;
+    }
+    while ((1 << max_length) < n) {
+        max_length++;
+    }
+    qsort(sorted, n, sizeof(sorted[0]), compare_by_weight);
+    
+    HuffmanNode nodes[2 * HUFFMAN_SYMBOLS - 1];
+    for (int i = 0; i < n; i++) {
+        nodes[i].weight = sorted[i][0];
+    }
+    int leaf = 0;
+    int internal = n;
+    for (int next = n; next < 2 * n - 1; next++) {
+        int pick[2];
+        for (int k = 0; k < 2; k++) {
+            if (leaf < n && (internal == next || nodes[leaf].weight <= nodes[internal].weight)) {
+                pick[k] = leaf++;
+            } else {
+                pick[k] = internal++;
+            }
+        }
+        nodes[next].weight = nodes[pick[0]].weight + nodes[pick[1]].weight;
+        nodes[pick[0]].parent = next;
+        nodes[pick[1]].parent = next;
+    }
+    
+    // Depths, root down: every node's parent comes after it
+    int depth[2 * HUFFMAN_SYMBOLS - 1];
+    depth[2 * n - 2] = 0;
+    for (int i = 2 * n - 3; i >= 0; i--) {
+        depth[i] = depth[nodes[i].parent] + 1;
+    }
+    
+    // Length limiting on the Kraft sum, counted in units of 2^-max_length
+    uint32_t kraft = 0;
+    for (int i = 0; i < n; i++) {
+        if (depth[i] > max_length) depth[i] = max_length;
+        kraft += 1u << (max_length - depth[i]);
+    }
+    uint32_t budget = 1u << max_length;
+    while (kraft > budget) {
+        // Lengthen the rarest symbol whose code can still grow
+        int best = -1;
+        for (int i = 0; i < n; i++) {
+            if (depth[i] < max_length && (best < 0 || depth[i] > depth[best])) {
+                best = i;
+            }
+        }
+        if (best < 0) break;  // Every code is at max_length (cannot happen once 2^max_length >= n)
+        kraft -= 1u << (max_length - depth[best] - 1);
+        depth[best]++;
+    }
+    // Give back slack, most frequent symbols first
+    for (int i = n - 1; i >= 0; i--) {
+        while (depth[i] > 1 && kraft + (1u << (max_length - depth[i])) <= budget) {
+            kraft += 1u << (max_length - depth[i]);
+            depth[i]--;
+        }
+    }
+    
+    for (int i = 0; i < n; i++) {
+        lengths[sorted[i][1]] = (unsigned char)depth[i];
+    }
+    return n;
 }
 
-// A standard function to build min heap
-void buildMinHeap(struct MinHeap* minHeap) {
-    int n = minHeap->size - 1;
-    int i;
-    for (i = (n - 1) / 2; i >= 0; --i)
-        minHeapify(minHeap, i);
+// Canonical codes for lengths[256], bit-reversed for LSB-first packing
+static void build_codes(const unsigned char* lengths, uint16_t* codes) {
+    int count[HUFFMAN_MAX_CODE_LENGTH + 1] = {0};
+    for (int s = 0; s < HUFFMAN_SYMBOLS; s++) {
+        count[lengths[s]]++;
+    }
+    count[0] = 0;
+    
+    int next[HUFFMAN_MAX_CODE_LENGTH + 1];
+    int code = 0;
+    for (int len = 1; len <= HUFFMAN_MAX_CODE_LENGTH; len++) {
+        code = (code + count[len - 1]) << 1;
+        next[len] = code;
+    }
+    for (int s = 0; s < HUFFMAN_SYMBOLS; s++) {
+        int len = lengths[s];
+        codes[s] = 0;
+        if (len == 0) continue;
+        
+        int c = next[len]++;
+        int reversed = 0;
+        for (int b = 0; b < len; b++) {
+            reversed = (reversed << 1) | ((c >> b) & 1);
+        }
+        codes[s] = (uint16_t)reversed;
+    }
 }
 
-// A utility function to print an array of size n
-void printArr(int arr[], int n) {
-    int i;
-    for (i = 0; i < n; ++i)
-        printf("%d", arr[i]);
-    printf("\n");
-}
+// ===== Encoder =====
 
-// Utility function to check if this node is leaf
-int isLeaf(struct MinHeapNode* root) {
-    return !(root->left) && !(root->right);
+// Output capacity that always suffices for huffman_compress
+EMSCRIPTEN_KEEPALIVE
+int huffman_max_compressed_size(int length) {
+    return HUFFMAN_HEADER_SIZE + length + HUFFMAN_SLACK;
 }
 
-// Creates a min heap of capacity
-// equal to size and inserts all character of
-// data[] in min heap. Initially size of
-// min heap is equal to capacity
-struct MinHeap* createAndBuildMinHeap(char data[], int freq[], int size) {
-    struct MinHeap* minHeap = createMinHeap(size);
-    for (int i = 0; i < size; ++i)
-        minHeap->array[i] = newNode(data[i], freq[i]);
-    minHeap->size = size;
-    buildMinHeap(minHeap);
-    return minHeap;
+static int store_raw(const unsigned char* input, int length, unsigned char* output, int capacity) {
+    if (capacity < HUFFMAN_HEADER_SIZE + length) return -1;
+    
+    output[0] = HUFFMAN_MODE_RAW;
+    store32(output + 1, (uint32_t)length);
+    memcpy(output + HUFFMAN_HEADER_SIZE, input, length);
+    return HUFFMAN_HEADER_SIZE + length;
 }
 
-// The main function that builds Huffman tree
-struct MinHeapNode* buildHuffmanTree(char data[], int freq[], int size) {
-    struct MinHeapNode *left, *right, *top;
-
-    // Step 1: Create a min heap of capacity
-    // equal to size.  Initially, there are
-    // modes equal to size.
-    struct MinHeap* minHeap = createAndBuildMinHeap(data, freq, size);
-
-    // Iterate while size of heap doesn't become 1
-    while (!isSizeOne(minHeap)) {
-        // Step 2: Extract the two minimum
-        // freq items from min heap
-        left = extractMin(minHeap);
-        right = extractMin(minHeap);
-
-        // Step 3:  Create a new internal
-        // node with frequency equal to the
-        // sum of the two nodes frequencies.
-        // Make the two extracted node as
-        // left and right children of this new node.
-        // Add this node to the min heap
-        // '$' is a special value for internal nodes, not used
-        top = newNode('$', left->freq + right->freq);
-        top->left = left;
-        top->right = right;
-
-        insertMinHeap(minHeap, top);
-    }
-
-    // Step 4: The remaining node is the
-    // root node and the tree is complete.
-    return extractMin(minHeap);
+// Compress length bytes of input into output. Falls back to storing the bytes
+// as is when coding would not make them smaller. Returns the compressed size,
+// or -1 if output is too small (huffman_max_compressed_size always fits)
+EMSCRIPTEN_KEEPALIVE
+int huffman_compress(const unsigned char* input, int length, unsigned char* output, int capacity) {
+    if (length < 0) return -1;
+    
+    uint32_t freq[HUFFMAN_SYMBOLS];
+    unsigned char lengths[HUFFMAN_SYMBOLS];
+    uint16_t codes[HUFFMAN_SYMBOLS];
+    huffman_count_frequencies(input, length, freq);
+    huffman_build_code_lengths(freq, lengths, HUFFMAN_MAX_CODE_LENGTH);
+    
+    uint64_t total_bits = 0;
+    for (int s = 0; s < HUFFMAN_SYMBOLS; s++) {
+        total_bits += (uint64_t)freq[s] * lengths[s];
+    }
+    int64_t coded_size = HUFFMAN_HEADER_SIZE + HUFFMAN_LENGTHS_SIZE + (int64_t)((total_bits + 7) >> 3);
+    if (coded_size >= HUFFMAN_HEADER_SIZE + (int64_t)length) {
+        return store_raw(input, length, output, capacity);
+    }
+    if (capacity < coded_size + HUFFMAN_SLACK) return -1;
+    
+    output[0] = HUFFMAN_MODE_CODED;
+    store32(output + 1, (uint32_t)length);
+    for (int i = 0; i < HUFFMAN_LENGTHS_SIZE; i++) {
+        output[HUFFMAN_HEADER_SIZE + i] = (unsigned char)(lengths[2 * i] | (lengths[2 * i + 1] << 4));
+    }
+    build_codes(lengths, codes);
+    
+    // Symbols go into a 64-bit accumulator; whole bytes are flushed with one
+    // 8-byte store. After a flush at most 7 bits remain, so four 12-bit codes
+    // always fit before the next one
+    unsigned char* out = output + HUFFMAN_HEADER_SIZE + HUFFMAN_LENGTHS_SIZE;
+    uint64_t bits = 0;
+    int count = 0;
+    int i = 0;
+    for (; i + 4 <= length; i += 4) {
+        bits |= (uint64_t)codes[input[i]] << count;
+        count += lengths[input[i]];
+        bits |= (uint64_t)codes[input[i + 1]] << count;
+        count += lengths[input[i + 1]];
+        bits |= (uint64_t)codes[input[i + 2]] << count;
+        count += lengths[input[i + 2]];
+        bits |= (uint64_t)codes[input[i + 3]] << count;
+        count += lengths[input[i + 3]];
+        memcpy(out, &bits, 8);
+        out += count >> 3;
+        bits >>= count & ~7;
+        count &= 7;
+    }
+    for (; i < length; i++) {
+        bits |= (uint64_t)codes[input[i]] << count;
+        count += lengths[input[i]];
+    }
+    memcpy(out, &bits, 8);
+    out += (count + 7) >> 3;
+    
+    return (int)(out - output);
 }
 
-// Prints huffman codes from the root of Huffman Tree.
-// It uses arr[] to store codes
-void printCodes(struct MinHeapNode* root, int arr[], int top) {
-    // Assign 0 to left edge and recur
-    if (root->left) {
-        arr[top] = 0;
-        printCodes(root->left, arr, top + 1);
+// ===== Decoder =====
+
+// Decoding table indexed by the next HUFFMAN_MAX_CODE_LENGTH bits. Each entry
+// holds every symbol whose code fits entirely in those bits, up to three:
+//   bits 0-23   the symbols, one per byte
+//   bits 24-27  bits consumed by all of them
+//   bits 28-29  how many symbols (0: the bits start no valid code)
+#define ENTRY_BITS(e) (((e) >> 24) & 15)
+#define ENTRY_COUNT(e) ((e) >> 28)
+
+// Build the table for lengths[256]; returns 0, or -1 if the lengths are not
+// a valid prefix code
+static int build_decode_table(const unsigned char* lengths, uint32_t* table) {
+    uint32_t kraft = 0;
+    for (int s = 0; s < HUFFMAN_SYMBOLS; s++) {
+        if (lengths[s] > HUFFMAN_MAX_CODE_LENGTH) return -1;
+        if (lengths[s] > 0) kraft += 1u << (HUFFMAN_MAX_CODE_LENGTH - lengths[s]);
     }
-
-    // Assign 1 to right edge and recur
-    if (root->right) {
-        arr[top] = 1;
-        printCodes(root->right, arr, top + 1);
+    if (kraft > HUFFMAN_TABLE_SIZE) return -1;
+    
+    // Single symbols first: (symbol, length) for every index starting with a code
+    uint16_t single[HUFFMAN_TABLE_SIZE];
+    uint16_t codes[HUFFMAN_SYMBOLS];
+    memset(single, 0, sizeof(single));
+    build_codes(lengths, codes);
+    for (int s = 0; s < HUFFMAN_SYMBOLS; s++) {
+        int len = lengths[s];
+        if (len == 0) continue;
+        for (int i = codes[s]; i < HUFFMAN_TABLE_SIZE; i += 1 << len) {
+            single[i] = (uint16_t)(s | (len << 8));
+        }
     }
-
-    // If this is a leaf node, then
-    // it contains one of the input
-    // characters, print the character
-    // and its code from arr[]
-    if (isLeaf(root)) {
-        printf("%c: ", root->data);
-        printArr(arr, top);
+    
+    // Then chain as many whole codes as fit in the index bits
+    for (int i = 0; i < HUFFMAN_TABLE_SIZE; i++) {
+        uint32_t entry = 0;
+        int used = 0;
+        int count = 0;
+        while (count < 3) {
+            uint16_t next = single[i >> used];
+            int len = next >> 8;
+            if (len == 0 || used + len > HUFFMAN_MAX_CODE_LENGTH) break;
+            entry |= (uint32_t)(next & 0xFF) << (8 * count);
+            used += len;
+            count++;
+        }
+        table[i] = entry | ((uint32_t)used << 24) | ((uint32_t)count << 28);
     }
+    return 0;
 }
 
-// Driver program to test above functions
-int main() {
-    char arr[] = { 'a', 'b', 'c', 'd', 'e', 'f' };
-    int freq[] = { 5, 9, 12, 13, 16, 45 };
-    int size = sizeof(arr) / sizeof(arr[0]);
-
-    printf("Char | Huffman Code\n");
-    printf("--------------------\n");
-
-    struct MinHeapNode* root = buildHuffmanTree(arr, freq, size);
-
-    int printArr[MAX_TREE_HT], top = 0;
-    printCodes(root, printArr, top);
-
-    printf("\nHuffman Coding Implementation Successful!\n");
+// Uncompressed size stored in a compressed buffer, or -1 if it is malformed
+EMSCRIPTEN_KEEPALIVE
+int huffman_decompressed_size(const unsigned char* input, int length) {
+    if (length < HUFFMAN_HEADER_SIZE || input[0] > HUFFMAN_MODE_CODED) return -1;
+    
+    uint32_t size = load32(input + 1);
+    return size > 0x7FFFFFFF ? -1 : (int)size;
+}
 
-    return 0;
+// Decompress a buffer made by huffman_compress into output. Returns the
+// number of bytes written, or -1 if the data is corrupt or output is smaller
+// than huffman_decompressed_size
+EMSCRIPTEN_KEEPALIVE
+int huffman_decompress(const unsigned char* input, int length, unsigned char* output, int capacity) {
+    int size = huffman_decompressed_size(input, length);
+    if (size < 0 || size > capacity) return -1;
+    
+    if (input[0] == HUFFMAN_MODE_RAW) {
+        if (length - HUFFMAN_HEADER_SIZE != size) return -1;
+        memcpy(output, input + HUFFMAN_HEADER_SIZE, size);
+        return size;
+    }
+    
+    if (length < HUFFMAN_HEADER_SIZE + HUFFMAN_LENGTHS_SIZE) return -1;
+    unsigned char lengths[HUFFMAN_SYMBOLS];
+    for (int i = 0; i < HUFFMAN_LENGTHS_SIZE; i++) {
+        lengths[2 * i] = input[HUFFMAN_HEADER_SIZE + i] & 15;
+        lengths[2 * i + 1] = input[HUFFMAN_HEADER_SIZE + i] >> 4;
+    }
+    uint32_t* table = (uint32_t*)malloc(HUFFMAN_TABLE_SIZE * sizeof(uint32_t));
+    if (build_decode_table(lengths, table) < 0) {
+        free(table);
+        return -1;
+    }
+    
+    const unsigned char* stream = input + HUFFMAN_HEADER_SIZE + HUFFMAN_LENGTHS_SIZE;
+    int64_t stream_bits = (int64_t)(length - HUFFMAN_HEADER_SIZE - HUFFMAN_LENGTHS_SIZE) * 8;
+    int64_t position = 0;  // Bits consumed
+    int written = 0;
+    int mask = HUFFMAN_TABLE_SIZE - 1;
+    
+    // Fast path: one unaligned 8-byte load gives at least 57 bits, enough for
+    // four lookups of up to three symbols each; every entry writes three bytes
+    // and keeps only its count
+    int64_t fast_end = stream_bits - 64;
+    while (position <= fast_end && written + 12 <= size) {
+        uint64_t bits = load64(stream + (position >> 3)) >> (position & 7);
+        int consumed = 0;
+        for (int k = 0; k < 4; k++) {
+            uint32_t entry = table[(bits >> consumed) & mask];
+            if (ENTRY_COUNT(entry) == 0) {
+                free(table);
+                return -1;
+            }
+            output[written] = (unsigned char)entry;
+            output[written + 1] = (unsigned char)(entry >> 8);
+            output[written + 2] = (unsigned char)(entry >> 16);
+            written += ENTRY_COUNT(entry);
+            consumed += ENTRY_BITS(entry);
+        }
+        position += consumed;
+    }
+    
+    // Tail: one symbol at a time, reading past the end as zero bits
+    while (written < size) {
+        uint32_t bits = 0;
+        for (int b = 0; b < HUFFMAN_MAX_CODE_LENGTH + 7; b += 8) {
+            int64_t byte = (position >> 3) + (b >> 3);
+            if (byte < stream_bits >> 3) bits |= (uint32_t)stream[byte] << b;
+        }
+        bits >>= position & 7;
+        uint32_t entry = table[bits & mask];
+        int len = ENTRY_COUNT(entry) == 0 ? 0 : lengths[entry & 0xFF];
+        if (len == 0 || position + len > stream_bits) {
+            free(table);
+            return -1;
+        }
+        output[written++] = (unsigned char)entry;
+        position += len;
+    }
+    
+    free(table);
+    return written;
 }
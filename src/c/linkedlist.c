@@ -1,123 +1,219 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <emscripten/emscripten.h>
 
+#define LIST_NODE_CAPACITY 64
+
+// Unrolled linked list: each node holds up to LIST_NODE_CAPACITY values in
+// order, so a walk skips whole nodes and a scan reads contiguous arrays.
+// Nodes are merged with their neighbor when deletions leave both small.
 typedef struct Node {
-    int data;
+    int count;
+    int values[LIST_NODE_CAPACITY];
     struct Node* next;
     struct Node* prev;
 } Node;
 
-Node* head = NULL;
-Node* tail = NULL;
-int list_size = 0;
+// The cursor caches the node of the last indexed access and the index of
+// its first value; list_get_at starts from whichever of head, tail and
+// cursor is closest, so walking the indices in order is O(1) per step
+typedef struct {
+    Node* head;
+    Node* tail;
+    int size;
+    
+    Node* cursor;
+    int cursor_start;
+} List;
+
+static Node* new_node(void) {
+    Node* node = (Node*)malloc(sizeof(Node));
+    node->count = 0;
+    node->next = NULL;
+    node->prev = NULL;
+    return node;
+}
+
+static void unlink_node(List* list, Node* node) {
+    if (node->prev != NULL) {
+        node->prev->next = node->next;
+    } else {
+        list->head = node->next;
+    }
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    } else {
+        list->tail = node->prev;
+    }
+    free(node);
+}
+
+EMSCRIPTEN_KEEPALIVE
+List* list_create() {
+    List* list = (List*)calloc(1, sizeof(List));
+    return list;
+}
 
 EMSCRIPTEN_KEEPALIVE
-void list_init() {
+void list_init(List* list) {
     // Free existing list
-    Node* current = head;
+    Node* current = list->head;
     while (current != NULL) {
         Node* temp = current;
         current = current->next;
         free(temp);
     }
-    head = NULL;
-    tail = NULL;
-    list_size = 0;
+    list->head = NULL;
+    list->tail = NULL;
+    list->size = 0;
+    list->cursor = NULL;
+    list->cursor_start = 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
-void list_insert_front(int value) {
-    Node* newNode = (Node*)malloc(sizeof(Node));
-    newNode->data = value;
-    newNode->next = head;
-    newNode->prev = NULL;
-    
-    if (head != NULL) {
-        head->prev = newNode;
+void list_destroy(List* list) {
+    list_init(list);
+    free(list);
+}
+
+EMSCRIPTEN_KEEPALIVE
+void list_insert_front(List* list, int value) {
+    Node* head = list->head;
+    if (head == NULL || head->count == LIST_NODE_CAPACITY) {
+        head = new_node();
+        head->next = list->head;
+        if (list->head != NULL) {
+            list->head->prev = head;
+        }
+        list->head = head;
+        if (list->tail == NULL) {
+            list->tail = head;
+        }
     }
-    head = newNode;
     
-    if (tail == NULL) {
-        tail = newNode;
+    memmove(head->values + 1, head->values, head->count * sizeof(int));
+    head->values[0] = value;
+    head->count++;
+    list->size++;
+    
+    // Everything after the head moved up one index
+    if (list->cursor != NULL && list->cursor != head) {
+        list->cursor_start++;
     }
-    list_size++;
 }
 
 EMSCRIPTEN_KEEPALIVE
-void list_insert_back(int value) {
-    Node* newNode = (Node*)malloc(sizeof(Node));
-    newNode->data = value;
-    newNode->next = NULL;
-    newNode->prev = tail;
-    
-    if (tail != NULL) {
-        tail->next = newNode;
+void list_insert_back(List* list, int value) {
+    Node* tail = list->tail;
+    if (tail == NULL || tail->count == LIST_NODE_CAPACITY) {
+        tail = new_node();
+        tail->prev = list->tail;
+        if (list->tail != NULL) {
+            list->tail->next = tail;
+        }
+        list->tail = tail;
+        if (list->head == NULL) {
+            list->head = tail;
+        }
     }
-    tail = newNode;
     
-    if (head == NULL) {
-        head = newNode;
-    }
-    list_size++;
+    tail->values[tail->count++] = value;
+    list->size++;
 }
 
+// Delete the first occurrence of value; returns 1 if one was found
 EMSCRIPTEN_KEEPALIVE
-int list_delete(int value) {
-    Node* current = head;
-    
-    while (current != NULL) {
-        if (current->data == value) {
-            if (current->prev != NULL) {
-                current->prev->next = current->next;
-            } else {
-                head = current->next;
-            }
+int list_delete(List* list, int value) {
+    for (Node* node = list->head; node != NULL; node = node->next) {
+        for (int i = 0; i < node->count; i++) {
+            if (node->values[i] != value) continue;
+            
+            memmove(node->values + i, node->values + i + 1, (node->count - i - 1) * sizeof(int));
+            node->count--;
+            list->size--;
             
-            if (current->next != NULL) {
-                current->next->prev = current->prev;
-            } else {
-                tail = current->prev;
+            if (node->count == 0) {
+                unlink_node(list, node);
+            } else if (node->next != NULL && node->count + node->next->count <= LIST_NODE_CAPACITY / 2) {
+                // Keep nodes at least a quarter full on average
+                Node* next = node->next;
+                memcpy(node->values + node->count, next->values, next->count * sizeof(int));
+                node->count += next->count;
+                unlink_node(list, next);
             }
             
-            free(current);
-            list_size--;
+            // Indices after the deletion shifted and nodes may be gone
+            list->cursor = NULL;
+            list->cursor_start = 0;
             return 1;
         }
-        current = current->next;
     }
     return 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int list_search(int value) {
-    Node* current = head;
+int list_search(List* list, int value) {
     int index = 0;
-    
-    while (current != NULL) {
-        if (current->data == value) {
-            return index;
+    for (Node* node = list->head; node != NULL; node = node->next) {
+        for (int i = 0; i < node->count; i++) {
+            if (node->values[i] == value) {
+                return index + i;
+            }
         }
-        current = current->next;
-        index++;
+        index += node->count;
     }
     return -1;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int list_get_size() {
-    return list_size;
+int list_get_size(List* list) {
+    return list->size;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int list_get_at(int index) {
-    if (index < 0 || index >= list_size) {
+int list_get_at(List* list, int index) {
+    if (index < 0 || index >= list->size) {
         return -1;
     }
     
-    Node* current = head;
-    for (int i = 0; i < index; i++) {
-        current = current->next;
+    // Start from the closest of head, tail and cursor
+    Node* node = list->head;
+    int start = 0;
+    if (list->size - index < index) {
+        node = list->tail;
+        start = list->size - node->count;
+    }
+    if (list->cursor != NULL) {
+        int distance = abs(index - list->cursor_start);
+        if (distance < index && distance < list->size - index) {
+            node = list->cursor;
+            start = list->cursor_start;
+        }
+    }
+    
+    while (index < start) {
+        node = node->prev;
+        start -= node->count;
+    }
+    while (index >= start + node->count) {
+        start += node->count;
+        node = node->next;
+    }
+    
+    list->cursor = node;
+    list->cursor_start = start;
+    return node->values[index - start];
+}
+
+// Copy every value in order into buffer (list_get_size ints); returns the count
+// One pass over the nodes, for reading the whole list from JS (HEAP32 at ptr >> 2)
+EMSCRIPTEN_KEEPALIVE
+int list_copy_to(List* list, int* buffer) {
+    int copied = 0;
+    for (Node* node = list->head; node != NULL; node = node->next) {
+        memcpy(buffer + copied, node->values, node->count * sizeof(int));
+        copied += node->count;
     }
-    return current->data;
+    return copied;
 }
@@ -9,57 +9,69 @@ typedef struct {
     int top;
 } Stack;
 
-Stack stack;
+// Each stack is its own instance: JS holds the pointer returned by
+// stack_create and passes it to every call
+EMSCRIPTEN_KEEPALIVE
+Stack* stack_create() {
+    Stack* stack = (Stack*)malloc(sizeof(Stack));
+    stack->top = -1;
+    return stack;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void stack_destroy(Stack* stack) {
+    free(stack);
+}
 
 EMSCRIPTEN_KEEPALIVE
-void stack_init() {
-    stack.top = -1;
+void stack_init(Stack* stack) {
+    stack->top = -1;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int stack_push(int value) {
-    if (stack.top >= MAX_SIZE - 1) {
+int stack_push(Stack* stack, int value) {
+    if (stack->top >= MAX_SIZE - 1) {
         return 0; // Stack overflow
     }
-    stack.data[++stack.top] = value;
+    stack->data[++stack->top] = value;
     return 1;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int stack_pop() {
-    if (stack.top < 0) {
+int stack_pop(Stack* stack) {
+    if (stack->top < 0) {
         return -1; // Stack underflow
     }
-    return stack.data[stack.top--];
+    return stack->data[stack->top--];
 }
 
 EMSCRIPTEN_KEEPALIVE
-int stack_peek() {
-    if (stack.top < 0) {
+int stack_peek(Stack* stack) {
+    if (stack->top < 0) {
         return -1;
     }
-    return stack.data[stack.top];
+    return stack->data[stack->top];
 }
 
 EMSCRIPTEN_KEEPALIVE
-int stack_is_empty() {
-    return stack.top < 0;
+int stack_is_empty(Stack* stack) {
+    return stack->top < 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int stack_size() {
-    return stack.top + 1;
+int stack_size(Stack* stack) {
+    return stack->top + 1;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int* stack_get_array() {
-    return stack.data;
+int* stack_get_array(Stack* stack) {
+    return stack->data;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int stack_get_at(int index) {
-    if (index < 0 || index > stack.top) {
+int stack_get_at(Stack* stack, int index) {
+    if (index < 0 || index > stack->top) {
         return -1;
     }
-    return stack.data[index];
+    return stack->data[index];
 }
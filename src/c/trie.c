@@ -11,7 +11,9 @@ typedef struct TrieNode {
     char character;
 } TrieNode;
 
-TrieNode* root = NULL;
+typedef struct {
+    TrieNode* root;
+} Trie;
 
 EMSCRIPTEN_KEEPALIVE
 TrieNode* trie_create_node() {
@@ -38,20 +40,29 @@ void trie_free_node(TrieNode* node) {
 }
 
 EMSCRIPTEN_KEEPALIVE
-void trie_init() {
-    if (root != NULL) {
-        trie_free_node(root);
-    }
-    root = trie_create_node();
+Trie* trie_create() {
+    Trie* trie = (Trie*)malloc(sizeof(Trie));
+    trie->root = trie_create_node();
+    return trie;
+}
+
+EMSCRIPTEN_KEEPALIVE
+void trie_destroy(Trie* trie) {
+    trie_free_node(trie->root);
+    free(trie);
 }
 
 EMSCRIPTEN_KEEPALIVE
-void trie_insert(const char* word) {
-    if (root == NULL) {
-        trie_init();
+void trie_init(Trie* trie) {
+    if (trie->root != NULL) {
+        trie_free_node(trie->root);
     }
-    
-    TrieNode* current = root;
+    trie->root = trie_create_node();
+}
+
+EMSCRIPTEN_KEEPALIVE
+void trie_insert(Trie* trie, const char* word) {
+    TrieNode* current = trie->root;
     int length = strlen(word);
     
     for (int i = 0; i < length; i++) {
@@ -72,10 +83,10 @@ void trie_insert(const char* word) {
 }
 
 EMSCRIPTEN_KEEPALIVE
-int trie_search(const char* word) {
-    if (root == NULL) return 0;
+int trie_search(Trie* trie, const char* word) {
+    if (trie->root == NULL) return 0;
     
-    TrieNode* current = root;
+    TrieNode* current = trie->root;
     int length = strlen(word);
     
     for (int i = 0; i < length; i++) {
@@ -95,10 +106,10 @@ int trie_search(const char* word) {
 }
 
 EMSCRIPTEN_KEEPALIVE
-int trie_starts_with(const char* prefix) {
-    if (root == NULL) return 0;
+int trie_starts_with(Trie* trie, const char* prefix) {
+    if (trie->root == NULL) return 0;
     
-    TrieNode* current = root;
+    TrieNode* current = trie->root;
     int length = strlen(prefix);
     
     for (int i = 0; i < length; i++) {
@@ -118,20 +129,20 @@ int trie_starts_with(const char* prefix) {
 }
 
 EMSCRIPTEN_KEEPALIVE
-int trie_has_child(int level, int child_index) {
-    if (root == NULL) return 0;
+int trie_has_child(Trie* trie, int level, int child_index) {
+    if (trie->root == NULL) return 0;
     if (child_index >= ALPHABET_SIZE) return 0;
     
     // This is a simplified version for visualization
     // In practice, you'd need to traverse to specific nodes
     if (level == 0) {
-        return root->children[child_index] != NULL;
+        return trie->root->children[child_index] != NULL;
     }
     
     return 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int trie_is_word_end(const char* word) {
-    return trie_search(word);
+int trie_is_word_end(Trie* trie, const char* word) {
+    return trie_search(trie, word);
 }
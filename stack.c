@@ -21,6 +21,7 @@ int isStackFull(Stack *s) {
 void push(Stack *s, UndoOperation op) {
     if (isStackFull(s)) {
         printf("Stack overflow! Cannot undo more operations.\n");
+        free(op.text);
         return;
     }
     s->top++;
@@ -29,7 +30,7 @@ void push(Stack *s, UndoOperation op) {
 
 // Pop operation from stack
 UndoOperation pop(Stack *s) {
-    UndoOperation emptyOp = {'\0', '\0', -1};
+    UndoOperation emptyOp = {'\0', '\0', -1, 0, NULL};
     if (isStackEmpty(s)) {
         printf("Stack is empty! Nothing to undo.\n");
         return emptyOp;
@@ -39,3 +40,9 @@ UndoOperation pop(Stack *s) {
     return op;
 }
 
+// Remove every operation, freeing their texts
+void clearStack(Stack *s) {
+    while (!isStackEmpty(s)) {
+        free(pop(s).text);
+    }
+}
@@ -8,12 +8,15 @@
 
 // Structure to store undo operation information
 typedef struct {
-    char operation;  // 'i' for insert, 'd' for delete
+    char operation;  // 'i' for insert, 'd' for delete, 'p' for bulk insert (paste)
     char data;       // Character that was inserted/deleted
     int position;    // Position where operation occurred
+    int count;       // Characters covered by a bulk insert (ends at position)
+    char *text;      // Copy of a bulk insert's characters (heap), NULL otherwise
 } UndoOperation;
 
 // Stack structure
+// A pushed operation's text belongs to the stack until it is popped
 typedef struct {
     UndoOperation items[MAX_STACK_SIZE];
     int top;  // Index of top element
@@ -25,6 +28,7 @@ int isStackEmpty(Stack *s);
 int isStackFull(Stack *s);
 void push(Stack *s, UndoOperation op);
 UndoOperation pop(Stack *s);
+void clearStack(Stack *s);
 
 #endif
 
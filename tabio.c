@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "tabio.h"
+
+// Work for one file being opened
+typedef struct LoadJob {
+    Tab *tab;                // Unloaded tab waiting for this file
+    char filename[256];      // Copy of the tab's filename (read by the worker)
+    Editor *editor;          // Built by the worker, NULL if the file could not be read
+    struct LoadJob *next;    // Next job in the ready list
+} LoadJob;
+
+// Finished loads handed from the workers to the main thread
+// DATA STRUCTURE: Linked list used as a stack under a mutex - workers push
+// as they finish, the main thread pops and installs in completion order
+typedef struct {
+    LoadJob *head;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;    // Signalled when a job is pushed
+} ReadyList;
+
+// Argument of a load task
+typedef struct {
+    LoadJob *job;
+    ReadyList *ready;
+} LoadTask;
+
+// Work for one modified tab being saved
+typedef struct {
+    Tab *tab;
+    Editor *editor;          // Resident tab: text is copied out by the worker
+    const TabSnapshot *snapshot;  // Evicted tab: snapshot text (streamed if compressed)
+    int length;
+    int status;              // writeTextFile / writeTextStream result
+} SaveJob;
+
+static ThreadPool tabIOPool;
+static int tabIOPoolReady = 0;
+static pthread_once_t tabIOPoolOnce = PTHREAD_ONCE_INIT;
+
+static void createTabIOPool(void) {
+    initThreadPool(&tabIOPool, getDefaultThreadCount());
+    tabIOPoolReady = 1;
+}
+
+// Pool used for tab file I/O (created on first use)
+// Kept apart from the analysis pool so slow disks never delay analysis passes
+ThreadPool* getTabIOPool(void) {
+    pthread_once(&tabIOPoolOnce, createTabIOPool);
+    return &tabIOPool;
+}
+
+// ========== OPEN ==========
+
+// Worker: read the file and build its editor, then hand it to the main thread
+static void loadFileTask(void *arg) {
+    LoadTask *task = (LoadTask *)arg;
+    LoadJob *job = task->job;
+    
+    int length = 0;
+    char *text = readTextFile(job->filename, &length);
+    if (text != NULL) {
+        job->editor = (Editor *)malloc(sizeof(Editor));
+        initEditor(job->editor);
+        loadText(job->editor, text, length);
+        free(text);
+    }
+    
+    pthread_mutex_lock(&(task->ready->lock));
+    job->next = task->ready->head;
+    task->ready->head = job;
+    pthread_cond_signal(&(task->ready->ready));
+    pthread_mutex_unlock(&(task->ready->lock));
+}
+
+// Open several files in tabs at once; returns the number of files loaded
+// Files already open keep their tabs. For the others, reading and building
+// the editor run in parallel, and each tab is installed the moment its
+// editor is ready. The last file's tab becomes current
+// ALGORITHM: Producer/consumer - workers produce editors, the main thread
+// alone touches the deque, so the deque needs no locking
+int openFilesInTabs(TabDeque *dq, const char **filenames, int count) {
+    LoadJob *jobs = (LoadJob *)malloc((count > 0 ? count : 1) * sizeof(LoadJob));
+    LoadTask *tasks = (LoadTask *)malloc((count > 0 ? count : 1) * sizeof(LoadTask));
+    ReadyList ready;
+    ready.head = NULL;
+    pthread_mutex_init(&(ready.lock), NULL);
+    pthread_cond_init(&(ready.ready), NULL);
+    
+    TaskGroup group;
+    initTaskGroup(&group);
+    ThreadPool *pool = getTabIOPool();
+    
+    int submitted = 0;
+    for (int i = 0; i < count; i++) {
+        Tab *tab = getTab(dq, openTab(dq, filenames[i]));
+        if (tab->state != TAB_UNLOADED || !tab->loadOnUse) {
+            printf("'%s' is already open.\n", filenames[i]);
+            continue;
+        }
+    
+        // The same file named twice in one batch is loaded once
+        int duplicate = 0;
+        for (int j = 0; j < submitted; j++) {
+            if (jobs[j].tab == tab) {
+                duplicate = 1;
+                break;
+            }
+        }
+        if (duplicate) {
+            continue;
+        }
+    
+        LoadJob *job = &jobs[submitted];
+        job->tab = tab;
+        strcpy(job->filename, tab->filename);
+        job->editor = NULL;
+        job->next = NULL;
+        tasks[submitted].job = job;
+        tasks[submitted].ready = &ready;
+        submitGroupTask(pool, &group, loadFileTask, &tasks[submitted]);
+        submitted++;
+    }
+    
+    // Install tabs in the order their files finish loading
+    int loaded = 0;
+    for (int installed = 0; installed < submitted; installed++) {
+        pthread_mutex_lock(&(ready.lock));
+        while (ready.head == NULL) {
+            pthread_cond_wait(&(ready.ready), &(ready.lock));
+        }
+        LoadJob *job = ready.head;
+        ready.head = job->next;
+        pthread_mutex_unlock(&(ready.lock));
+    
+        if (job->editor == NULL) {
+            printf("Error: Cannot open file '%s'\n", job->filename);
+        } else if (installTabEditor(dq, job->tab, job->editor)) {
+            printf("File '%s' loaded successfully.\n", job->filename);
+            loaded++;
+        } else {
+            freeEditor(job->editor);
+            free(job->editor);
+        }
+    }
+    
+    waitTaskGroup(&group);
+    freeTaskGroup(&group);
+    pthread_cond_destroy(&(ready.ready));
+    pthread_mutex_destroy(&(ready.lock));
+    free(tasks);
+    free(jobs);
+    return loaded;
+}
+
+// ========== SAVE ==========
+
+// Text source for writeTextStream: decode a range of a compressed snapshot
+static int readColdText(void *ctx, int start, int length, char *out) {
+    return readColdRange((const ColdText *)ctx, start, length, out);
+}
+
+// Worker: write one tab's text atomically
+// A compressed snapshot is decoded and written one chunk at a time
+static void saveTabTask(void *arg) {
+    SaveJob *job = (SaveJob *)arg;
+    if (job->editor != NULL) {
+        char *text = getTextRange(job->editor, 0, job->length);
+        job->status = writeTextFile(job->tab->filename, text, job->length);
+        free(text);
+    } else if (job->snapshot->text != NULL || job->length == 0) {
+        job->status = writeTextFile(job->tab->filename, job->snapshot->text, job->length);
+    } else {
+        job->status = writeTextStream(job->tab->filename, readColdText,
+                                      (void *)&(job->snapshot->cold), job->length, COLD_CHUNK_SIZE);
+    }
+}
+
+// Save every tab with unsaved changes, in parallel; returns the number saved
+// Evicted tabs are written straight from their snapshots without being
+// restored. Each write is atomic, so a failure leaves that file as it was
+// The deque is not touched while workers run; each worker reads only its own tab
+int saveAllTabs(TabDeque *dq) {
+    SaveJob *jobs = (SaveJob *)malloc((dq->count > 0 ? dq->count : 1) * sizeof(SaveJob));
+    int jobCount = 0;
+    
+    for (int i = 0; i < dq->count; i++) {
+        Tab *tab = getTab(dq, i);
+        SaveJob *job = &jobs[jobCount];
+        job->tab = tab;
+        job->editor = NULL;
+        job->snapshot = NULL;
+        job->status = -1;
+        if (tab->state == TAB_RESIDENT && tab->editor->modified) {
+            job->editor = tab->editor;
+            job->length = tab->editor->length;
+            jobCount++;
+        } else if (tab->state == TAB_EVICTED && tab->snapshot.modified) {
+            job->snapshot = &(tab->snapshot);
+            job->length = tab->snapshot.length;
+            jobCount++;
+        }
+    }
+    
+    if (jobCount == 0) {
+        printf("No modified tabs to save.\n");
+        free(jobs);
+        return 0;
+    }
+    
+    TaskGroup group;
+    initTaskGroup(&group);
+    ThreadPool *pool = getTabIOPool();
+    for (int i = 0; i < jobCount; i++) {
+        submitGroupTask(pool, &group, saveTabTask, &jobs[i]);
+    }
+    waitTaskGroup(&group);
+    freeTaskGroup(&group);
+    
+    // Report in tab order and mark the written tabs clean
+    int saved = 0;
+    for (int i = 0; i < jobCount; i++) {
+        SaveJob *job = &jobs[i];
+        if (job->status != 0) {
+            printf("Error: Cannot create file '%s'\n", job->tab->filename);
+            continue;
+        }
+        if (job->editor != NULL) {
+            job->editor->modified = 0;
+        } else {
+            job->tab->snapshot.modified = 0;
+        }
+        printf("File '%s' saved successfully.\n", job->tab->filename);
+        saved++;
+    }
+    
+    free(jobs);
+    return saved;
+}
+
+// Stop the tab I/O pool's workers (call once at exit)
+void shutdownTabIOPool(void) {
+    if (tabIOPoolReady) {
+        freeThreadPool(&tabIOPool);
+        tabIOPoolReady = 0;
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef TABIO_H
+#define TABIO_H
+
+#include "deque.h"
+#include "threadpool.h"
+
+// BATCH FILE I/O across tabs
+// Opening several files reads each one and builds its editor (text list,
+// dictionary) on a worker pool; the main thread installs each tab as soon as
+// its editor is ready. Saving writes every modified tab in parallel, each
+// through an atomic temporary-file-and-rename write
+
+// Function declarations
+ThreadPool* getTabIOPool(void);
+int openFilesInTabs(TabDeque *dq, const char **filenames, int count);
+int saveAllTabs(TabDeque *dq);
+void shutdownTabIOPool(void);
+
+#endif
@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/select.h>
+#include "terminal.h"
+#include "viewport.h"
+
+#define CTRL_KEY(k) ((k) & 0x1f)
+
+// Result of applying part of a batch
+#define BATCH_DONE       0   // All bytes consumed
+#define BATCH_INCOMPLETE 1   // Stopped at an escape sequence cut off by the end of the read
+#define BATCH_QUIT       2   // Ctrl-Q
+
+// Front end state for one session
+typedef struct {
+    Editor *e;
+    const char *filename;
+    Viewport viewport;
+    int desiredCol;       // Column kept across Up/Down moves (-1 = use the cursor's)
+    char *run;            // Scratch buffer for a run of typed characters
+    int runCapacity;
+} TerminalSession;
+
+static struct termios savedTermios;
+
+// ========== RAW MODE ==========
+
+// Switch the terminal to raw mode: no echo, no line buffering, no signals;
+// read() returns whatever is already buffered without waiting
+static int enableRawMode(int fd) {
+    if (!isatty(fd) || tcgetattr(fd, &savedTermios) == -1) {
+        return -1;
+    }
+
+    struct termios raw = savedTermios;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_oflag &= ~(OPOST);
+    raw.c_cflag |= CS8;
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    return tcsetattr(fd, TCSAFLUSH, &raw);
+}
+
+static void disableRawMode(int fd) {
+    tcsetattr(fd, TCSAFLUSH, &savedTermios);
+}
+
+// Write a control sequence straight to the terminal
+static void writeSequence(int fd, const char *sequence) {
+    int length = (int)strlen(sequence);
+    int written = 0;
+    while (written < length) {
+        ssize_t n = write(fd, sequence + written, length - written);
+        if (n <= 0) {
+            break;
+        }
+        written += (int)n;
+    }
+}
+
+// ========== INPUT ==========
+
+// Wait for input, then drain everything already buffered
+// Returns the number of new bytes (0 on error)
+static int readBatch(int fd, InputBuffer *in) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(fd, &readable);
+    if (select(fd + 1, &readable, NULL, NULL, NULL) <= 0) {
+        return 0;
+    }
+
+    int total = 0;
+    while (1) {
+        if (in->length + TERMINAL_READ_CHUNK > in->capacity) {
+            in->capacity = (in->capacity == 0) ? TERMINAL_READ_CHUNK * 2 : in->capacity * 2;
+            in->data = (char *)realloc(in->data, in->capacity);
+        }
+        ssize_t n = read(fd, in->data + in->length, TERMINAL_READ_CHUNK);
+        if (n <= 0) {
+            break;
+        }
+        in->length += (int)n;
+        total += (int)n;
+    }
+    return total;
+}
+
+// Characters inserted as typed text (UTF-8 bytes included)
+static int isTypedByte(unsigned char c) {
+    return c >= 32 ? c != 127 : (c == '\t' || c == '\r' || c == '\n');
+}
+
+// ========== CURSOR MOVEMENT ==========
+
+// Length of a line without its '\n'
+static int lineTextLength(LineCache *lc, int index) {
+    int length = getCachedLine(lc, index)->length;
+    return (index < getCachedLineCount(lc) - 1) ? length - 1 : length;
+}
+
+// Move the cursor 'delta' lines up (negative) or down, keeping the desired column
+// ALGORITHM: Line index lookups - O(log n) plus the walk to the new offset
+static void moveCursorLines(TerminalSession *s, int delta) {
+    LineCache *lc = refreshLexedLines(s->e);
+    int lineStart = 0;
+    int line = findLineAt(lc, s->e->cursorPos, &lineStart);
+    if (s->desiredCol < 0) {
+        s->desiredCol = s->e->cursorPos - lineStart;
+    }
+
+    int target = line + delta;
+    if (target < 0) {
+        target = 0;
+    }
+    if (target > getCachedLineCount(lc) - 1) {
+        target = getCachedLineCount(lc) - 1;
+    }
+
+    int col = s->desiredCol;
+    if (col > lineTextLength(lc, target)) {
+        col = lineTextLength(lc, target);
+    }
+    setCursorPosition(s->e, getLineStart(lc, target) + col);
+}
+
+// Move the cursor to the start or end of its line
+static void moveCursorToLineEdge(Editor *e, int toEnd) {
+    LineCache *lc = refreshLexedLines(e);
+    int lineStart = 0;
+    int line = findLineAt(lc, e->cursorPos, &lineStart);
+    setCursorPosition(e, toEnd ? lineStart + lineTextLength(lc, line) : lineStart);
+}
+
+// ========== KEY HANDLING ==========
+
+// Copy text into the run buffer as it should be inserted; returns the run length
+// Enter sends '\r' in raw mode and a pasted "\r\n" is one line break
+static int fillRun(TerminalSession *s, const char *data, int length) {
+    int runLength = 0;
+    if (length > s->runCapacity) {
+        s->runCapacity = (length < 256) ? 256 : length;
+        s->run = (char *)realloc(s->run, s->runCapacity);
+    }
+    for (int j = 0; j < length; j++) {
+        if (data[j] == '\r') {
+            s->run[runLength++] = '\n';
+            if (j + 1 < length && data[j + 1] == '\n') {
+                j++;
+            }
+        } else {
+            s->run[runLength++] = data[j];
+        }
+    }
+    return runLength;
+}
+
+// Insert the run of typed bytes at data[i] as one edit; returns its length
+static int applyTypedRun(TerminalSession *s, const char *data, int i, int length) {
+    int j = i;
+    while (j < length && isTypedByte((unsigned char)data[j])) {
+        j++;
+    }
+    insertText(s->e, s->run, fillRun(s, data + i, j - i));
+    s->desiredCol = -1;
+    return j - i;
+}
+
+// Bracketed paste: the terminal wraps pasted text in ESC[200~ ... ESC[201~
+// The whole paste is inserted as one edit, however many reads it took to arrive
+// Returns the bytes used from data[i] (after ESC[200~), or 0 if the end marker has not arrived
+static int applyPaste(TerminalSession *s, const char *data, int i, int length) {
+    static const char endMarker[] = "\x1b[201~";
+    int markerLength = (int)strlen(endMarker);
+    for (int j = i; j + markerLength <= length; j++) {
+        if (data[j] == 27 && memcmp(data + j, endMarker, markerLength) == 0) {
+            insertText(s->e, s->run, fillRun(s, data + i, j - i));
+            s->desiredCol = -1;
+            return j - i + markerLength;
+        }
+    }
+    return 0;
+}
+
+// Apply an escape sequence starting at data[i]; returns its length, or 0 if it is incomplete
+static int applyEscape(TerminalSession *s, const char *data, int i, int length) {
+    if (i + 1 >= length) {
+        return 0;
+    }
+    if (data[i + 1] != '[' && data[i + 1] != 'O') {
+        return 1;   // Lone ESC (or Alt+key): ignored
+    }
+
+    // CSI / SS3: parameters, then a final byte in 0x40..0x7E
+    int j = i + 2;
+    int param = 0;
+    while (j < length && ((data[j] >= '0' && data[j] <= '9') || data[j] == ';')) {
+        if (data[j] != ';') {
+            param = param * 10 + (data[j] - '0');
+        }
+        j++;
+    }
+    if (j >= length) {
+        return 0;
+    }
+
+    Editor *e = s->e;
+    int vertical = 0;
+    switch (data[j]) {
+        case 'A': moveCursorLines(s, -1); vertical = 1; break;
+        case 'B': moveCursorLines(s, 1); vertical = 1; break;
+        case 'C': moveCursorRight(e); break;
+        case 'D': moveCursorLeft(e); break;
+        case 'H': moveCursorToLineEdge(e, 0); break;
+        case 'F': moveCursorToLineEdge(e, 1); break;
+        case '~':
+            if (param == 200) {
+                int pasted = applyPaste(s, data, j + 1, length);
+                if (pasted == 0) {
+                    return 0;
+                }
+                return j - i + 1 + pasted;
+            } else if (param == 3) {
+                if (e->cursor->next != e->tail) {
+                    deleteChar(e);
+                }
+            } else if (param == 1 || param == 7) {
+                moveCursorToLineEdge(e, 0);
+            } else if (param == 4 || param == 8) {
+                moveCursorToLineEdge(e, 1);
+            } else if (param == 5 || param == 6) {
+                moveCursorLines(s, (param == 5 ? -1 : 1) * s->viewport.rows);
+                vertical = 1;
+            }
+            break;
+        default:
+            break;
+    }
+    if (!vertical) {
+        s->desiredCol = -1;
+    }
+    return j - i + 1;
+}
+
+// Apply a batch of input bytes
+// Returns BATCH_DONE, BATCH_INCOMPLETE (*consumed tells how far it got) or BATCH_QUIT
+static int applyBatch(TerminalSession *s, const char *data, int length, int *consumed) {
+    Editor *e = s->e;
+    int i = 0;
+
+    while (i < length) {
+        unsigned char c = (unsigned char)data[i];
+
+        if (isTypedByte(c)) {
+            i += applyTypedRun(s, data, i, length);
+        } else if (c == 27) {
+            int n = applyEscape(s, data, i, length);
+            if (n == 0) {
+                *consumed = i;
+                return BATCH_INCOMPLETE;
+            }
+            i += n;
+        } else {
+            if (c == 127 || c == CTRL_KEY('h')) {
+                // Backspace: delete the character before the cursor
+                if (e->cursorPos > 0) {
+                    moveCursorLeft(e);
+                    deleteChar(e);
+                }
+            } else if (c == CTRL_KEY('s')) {
+                // stdout is silenced during the session, so the outcome goes to the status line
+                if (saveFile(e, s->filename) == 0) {
+                    snprintf(s->viewport.message, sizeof(s->viewport.message), "Saved %s", s->filename);
+                } else {
+                    snprintf(s->viewport.message, sizeof(s->viewport.message),
+                             "Error: Cannot create file '%s'", s->filename);
+                }
+            } else if (c == CTRL_KEY('z')) {
+                undo(e);
+            } else if (c == CTRL_KEY('y')) {
+                redo(e);
+            } else if (c == CTRL_KEY('q')) {
+                *consumed = i + 1;
+                return BATCH_QUIT;
+            }
+            s->desiredCol = -1;
+            i++;
+        }
+    }
+
+    *consumed = length;
+    return BATCH_DONE;
+}
+
+// ========== SESSION ==========
+
+// Redraw once for the whole batch, following terminal resizes
+static void drawFrame(TerminalSession *s, int termFd) {
+    int rows = 24;
+    int cols = 80;
+    getTerminalSize(termFd, &rows, &cols);
+    if (rows - 1 != s->viewport.rows || cols != s->viewport.cols) {
+        resizeViewport(&(s->viewport), rows - 1, cols);
+        writeSequence(termFd, "\x1b[2J");
+    }
+    renderViewport(&(s->viewport), s->e);
+}
+
+// Full-screen editing of e until Ctrl-Q
+// Editor functions report through printf; stdout is pointed at /dev/null for
+// the session so their messages cannot scribble over the screen, and frames go
+// to a duplicate of the terminal descriptor
+// Returns 0, or -1 when stdin/stdout are not a terminal
+int runTerminalEditor(Editor *e, const char *filename) {
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+        printf("Full-screen mode needs an interactive terminal.\n");
+        return -1;
+    }
+
+    fflush(stdout);
+    int termFd = dup(STDOUT_FILENO);
+    int nullFd = open("/dev/null", O_WRONLY);
+    if (termFd == -1 || nullFd == -1 || enableRawMode(STDIN_FILENO) == -1) {
+        printf("Could not switch the terminal to raw mode.\n");
+        if (termFd != -1) {
+            close(termFd);
+        }
+        if (nullFd != -1) {
+            close(nullFd);
+        }
+        return -1;
+    }
+    dup2(nullFd, STDOUT_FILENO);
+    close(nullFd);
+
+    TerminalSession s;
+    s.e = e;
+    s.filename = filename;
+    s.desiredCol = -1;
+    s.run = NULL;
+    s.runCapacity = 0;
+    initViewport(&(s.viewport), 23, 80, 1);
+    s.viewport.fd = termFd;
+    s.viewport.placeCursor = 1;
+    snprintf(s.viewport.message, sizeof(s.viewport.message),
+             "^S save  ^Z undo  ^Y redo  ^Q menu");
+
+    InputBuffer in = {NULL, 0, 0};
+    // Alternate screen keeps the menu's scrollback; bracketed paste marks pasted text
+    writeSequence(termFd, "\x1b[?1049h\x1b[?2004h\x1b[2J");
+    drawFrame(&s, termFd);
+
+    int status = BATCH_DONE;
+    while (status != BATCH_QUIT && readBatch(STDIN_FILENO, &in) > 0) {
+        int consumed = 0;
+        s.viewport.message[0] = '\0';
+        status = applyBatch(&s, in.data, in.length, &consumed);
+
+        // Keep an escape sequence cut off by the end of the read for the next batch
+        memmove(in.data, in.data + consumed, in.length - consumed);
+        in.length -= consumed;
+
+        if (status != BATCH_QUIT) {
+            drawFrame(&s, termFd);
+        }
+    }
+
+    writeSequence(termFd, "\x1b[?2004l\x1b[?1049l");
+    disableRawMode(STDIN_FILENO);
+    fflush(stdout);
+    dup2(termFd, STDOUT_FILENO);
+    close(termFd);
+
+    freeViewport(&(s.viewport));
+    free(s.run);
+    free(in.data);
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef TERMINAL_H
+#define TERMINAL_H
+
+#include "editor.h"
+
+// RAW-MODE TERMINAL FRONT END
+// Keystrokes are read in batches: everything waiting in the input buffer is
+// taken at once, each run of typed or pasted characters is inserted as one
+// edit (a bracketed paste as a whole, even when it spans several reads), and
+// the screen is redrawn once per batch through a diffing viewport
+//
+// Keys: arrows, Home/End, PageUp/PageDown, Backspace, Delete,
+//       Ctrl-S save, Ctrl-Z undo, Ctrl-Y redo, Ctrl-Q back to the menu
+
+#define TERMINAL_READ_CHUNK 4096   // Bytes requested per read() while draining input
+
+// Bytes read from the terminal but not yet applied
+// DATA STRUCTURE: Growable byte array - a paste of any size is drained into it
+// before the batch is applied; an escape sequence cut off by the end of a read
+// stays at the front until the rest arrives
+typedef struct {
+    char *data;
+    int length;
+    int capacity;
+} InputBuffer;
+
+// Function declarations
+int runTerminalEditor(Editor *e, const char *filename);
+
+#endif
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "threadpool.h"
+
+#define POOL_INITIAL_CAPACITY 64
+
+// Worker loop: run tasks until the pool shuts down
+static void* workerMain(void *arg) {
+    ThreadPool *pool = (ThreadPool *)arg;
+    
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->count == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->hasWork, &pool->lock);
+        }
+        if (pool->count == 0 && pool->shutdown) {
+            break;
+        }
+        
+        // Dequeue the oldest task (FIFO)
+        Task task = pool->tasks[pool->front];
+        pool->front = (pool->front + 1) % pool->capacity;
+        pool->count--;
+        pool->running++;
+        pthread_mutex_unlock(&pool->lock);
+        
+        task.function(task.arg);
+        if (task.group != NULL) {
+            pthread_mutex_lock(&task.group->lock);
+            if (--task.group->pending == 0) {
+                pthread_cond_broadcast(&task.group->done);
+            }
+            pthread_mutex_unlock(&task.group->lock);
+        }
+        
+        pthread_mutex_lock(&pool->lock);
+        pool->running--;
+        if (pool->count == 0 && pool->running == 0) {
+            pthread_cond_broadcast(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// Initialize pool with the given number of workers
+int initThreadPool(ThreadPool *pool, int threadCount) {
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+    
+    pool->tasks = (Task *)malloc(POOL_INITIAL_CAPACITY * sizeof(Task));
+    pool->capacity = POOL_INITIAL_CAPACITY;
+    pool->front = 0;
+    pool->count = 0;
+    pool->running = 0;
+    pool->shutdown = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->hasWork, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+    
+    pool->threads = (pthread_t *)malloc(threadCount * sizeof(pthread_t));
+    pool->threadCount = 0;
+    for (int i = 0; i < threadCount; i++) {
+        if (pthread_create(&pool->threads[i], NULL, workerMain, pool) != 0) {
+            printf("Warning: could only start %d worker thread(s).\n", i);
+            break;
+        }
+        pool->threadCount++;
+    }
+    
+    return pool->threadCount;
+}
+
+// Queue a task; the queue grows instead of blocking the caller
+void submitTask(ThreadPool *pool, TaskFunction function, void *arg) {
+    submitGroupTask(pool, NULL, function, arg);
+}
+
+// Queue a task that reports completion to a task group
+void submitGroupTask(ThreadPool *pool, TaskGroup *group, TaskFunction function, void *arg) {
+    if (group != NULL) {
+        pthread_mutex_lock(&group->lock);
+        group->pending++;
+        pthread_mutex_unlock(&group->lock);
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    
+    if (pool->count == pool->capacity) {
+        int newCapacity = pool->capacity * 2;
+        Task *tasks = (Task *)malloc(newCapacity * sizeof(Task));
+        for (int i = 0; i < pool->count; i++) {
+            tasks[i] = pool->tasks[(pool->front + i) % pool->capacity];
+        }
+        free(pool->tasks);
+        pool->tasks = tasks;
+        pool->capacity = newCapacity;
+        pool->front = 0;
+    }
+    
+    Task task = {function, arg, group};
+    pool->tasks[(pool->front + pool->count) % pool->capacity] = task;
+    pool->count++;
+    
+    pthread_cond_signal(&pool->hasWork);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Block until every submitted task has finished
+void waitThreadPool(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->count > 0 || pool->running > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Initialize an empty task group
+void initTaskGroup(TaskGroup *group) {
+    group->pending = 0;
+    pthread_mutex_init(&group->lock, NULL);
+    pthread_cond_init(&group->done, NULL);
+}
+
+// Block until every task submitted to the group has finished
+void waitTaskGroup(TaskGroup *group) {
+    pthread_mutex_lock(&group->lock);
+    while (group->pending > 0) {
+        pthread_cond_wait(&group->done, &group->lock);
+    }
+    pthread_mutex_unlock(&group->lock);
+}
+
+// Release a task group (all its tasks must have finished)
+void freeTaskGroup(TaskGroup *group) {
+    pthread_mutex_destroy(&group->lock);
+    pthread_cond_destroy(&group->done);
+}
+
+// Finish queued work, stop the workers and free the pool
+void freeThreadPool(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->hasWork);
+    pthread_mutex_unlock(&pool->lock);
+    
+    for (int i = 0; i < pool->threadCount; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    
+    free(pool->threads);
+    free(pool->tasks);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->hasWork);
+    pthread_cond_destroy(&pool->idle);
+}
+
+// Number of online processors (at least 1)
+int getDefaultThreadCount(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+}
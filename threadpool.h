@@ -0,0 +1,54 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+
+// Thread pool for PARALLEL DOCUMENT PASSES
+// Fixed set of worker threads pulling tasks from a growable circular queue
+
+typedef void (*TaskFunction)(void *arg);
+
+// Completion counter for a batch of tasks, so callers sharing one pool
+// can wait for their own work only
+typedef struct {
+    int pending;             // Tasks submitted but not yet finished
+    pthread_mutex_t lock;
+    pthread_cond_t done;     // Signalled when pending drops to 0
+} TaskGroup;
+
+// A unit of work for the pool
+typedef struct {
+    TaskFunction function;  // Function run by a worker
+    void *arg;              // Argument passed to the function
+    TaskGroup *group;       // Group to notify on completion (may be NULL)
+} Task;
+
+// Thread pool structure
+typedef struct {
+    pthread_t *threads;      // Worker threads
+    int threadCount;         // Number of workers
+    
+    Task *tasks;             // Circular queue of pending tasks
+    int capacity;            // Allocated queue slots
+    int front;               // Index of next task to run
+    int count;               // Number of pending tasks
+    int running;             // Tasks currently executing
+    int shutdown;            // 1 once the pool is being destroyed
+    
+    pthread_mutex_t lock;    // Protects all fields above
+    pthread_cond_t hasWork;  // Signalled when a task is queued
+    pthread_cond_t idle;     // Signalled when the pool runs out of work
+} ThreadPool;
+
+// Function declarations
+int initThreadPool(ThreadPool *pool, int threadCount);
+void submitTask(ThreadPool *pool, TaskFunction function, void *arg);
+void waitThreadPool(ThreadPool *pool);
+void initTaskGroup(TaskGroup *group);
+void submitGroupTask(ThreadPool *pool, TaskGroup *group, TaskFunction function, void *arg);
+void waitTaskGroup(TaskGroup *group);
+void freeTaskGroup(TaskGroup *group);
+void freeThreadPool(ThreadPool *pool);
+int getDefaultThreadCount(void);
+
+#endif
@@ -1,8 +1,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <sched.h>
 #include "trie.h"
+#include "utf8.h"
 
 // Create a new trie node
 TrieNode* createTrieNode(void) {
@@ -10,71 +11,273 @@ TrieNode* createTrieNode(void) {
     node->isEndOfWord = 0;
     node->frequency = 0;
     
-    // Initialize all children to NULL
-    for (int i = 0; i < ALPHABET_SIZE; i++) {
-        node->children[i] = NULL;
-    }
+    // No children yet: arrays are allocated as children are added
+    node->childMask = 0;
+    node->children = NULL;
+    node->extraKeys = NULL;
+    node->extraChildren = NULL;
+    node->extraCount = 0;
     
     return node;
 }
 
+// Copy a node; the child arrays are duplicated, the children are shared
+static TrieNode* copyTrieNode(TrieNode *node) {
+    TrieNode *copy = (TrieNode *)malloc(sizeof(TrieNode));
+    *copy = *node;
+    
+    int letters = __builtin_popcount(node->childMask);
+    if (letters > 0) {
+        copy->children = (TrieNode **)malloc(letters * sizeof(TrieNode *));
+        memcpy(copy->children, node->children, letters * sizeof(TrieNode *));
+    }
+    if (node->extraCount > 0) {
+        copy->extraKeys = (unsigned char *)malloc(node->extraCount * sizeof(unsigned char));
+        copy->extraChildren = (TrieNode **)malloc(node->extraCount * sizeof(TrieNode *));
+        memcpy(copy->extraKeys, node->extraKeys, node->extraCount * sizeof(unsigned char));
+        memcpy(copy->extraChildren, node->extraChildren, node->extraCount * sizeof(TrieNode *));
+    }
+    return copy;
+}
+
+// Free one node and its child arrays, but not the children themselves
+static void freeTrieNodeShallow(TrieNode *node) {
+    free(node->children);
+    free(node->extraKeys);
+    free(node->extraChildren);
+    free(node);
+}
+
 // Initialize trie
 void initTrie(Trie *t) {
-    t->root = createTrieNode();
+    atomic_init(&t->root, createTrieNode());
+    atomic_init(&t->globalEpoch, 1);
+    for (int i = 0; i < TRIE_MAX_READERS; i++) {
+        atomic_init(&t->readers[i].epoch, 0);
+    }
+    pthread_mutex_init(&t->writeLock, NULL);
+    t->retired = NULL;
 }
 
-// Insert a word into the trie
-void insertWord(Trie *t, const char *word) {
-    if (word == NULL || strlen(word) == 0) {
-        return;
+// Enter a read section and return the current root snapshot
+// The snapshot stays valid (and unchanged) until endTrieRead
+// CONCURRENCY: Claims a free reader slot with one compare-and-swap; never waits on writers
+TrieNode* beginTrieRead(Trie *t, int *slot) {
+    static _Thread_local unsigned int hint = 0;
+    unsigned long epoch = atomic_load(&t->globalEpoch);
+    
+    while (1) {
+        for (int k = 0; k < TRIE_MAX_READERS; k++) {
+            int i = (hint + k) % TRIE_MAX_READERS;
+            unsigned long expected = 0;
+            if (atomic_compare_exchange_strong(&t->readers[i].epoch, &expected, epoch)) {
+                hint = i;
+                *slot = i;
+                return atomic_load(&t->root);
+            }
+        }
+        // More than TRIE_MAX_READERS threads are reading: let one finish
+        sched_yield();
+    }
+}
+
+// Leave a read section
+void endTrieRead(Trie *t, int slot) {
+    atomic_store(&t->readers[slot].epoch, 0);
+}
+
+// Free retired nodes that no active reader can still reach (writeLock held)
+static void reclaimRetired(Trie *t) {
+    unsigned long oldest = (unsigned long)-1;
+    for (int i = 0; i < TRIE_MAX_READERS; i++) {
+        unsigned long epoch = atomic_load(&t->readers[i].epoch);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    
+    RetiredNode **link = &t->retired;
+    while (*link != NULL) {
+        RetiredNode *r = *link;
+        if (r->epoch < oldest) {
+            *link = r->next;
+            freeTrieNodeShallow(r->node);
+            free(r);
+        } else {
+            link = &r->next;
+        }
+    }
+}
+
+// Queue a replaced node for reclamation (writeLock held)
+static void retireNode(Trie *t, TrieNode *node, unsigned long epoch) {
+    RetiredNode *r = (RetiredNode *)malloc(sizeof(RetiredNode));
+    r->node = node;
+    r->epoch = epoch;
+    r->next = t->retired;
+    t->retired = r;
+}
+
+// Find the slot holding the child for one byte of a folded word (NULL if absent)
+// ALGORITHM: Letters are found with one bit test and a popcount - O(1)
+static TrieNode** getChildSlot(TrieNode *node, unsigned char c) {
+    if (c >= 'a' && c <= 'z') {
+        unsigned int bit = 1u << (c - 'a');
+        if (!(node->childMask & bit)) {
+            return NULL;
+        }
+        return &node->children[__builtin_popcount(node->childMask & (bit - 1))];
+    }
+    
+    // Binary search in the sorted child map
+    int lo = 0;
+    int hi = node->extraCount - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (node->extraKeys[mid] == c) {
+            return &node->extraChildren[mid];
+        }
+        if (node->extraKeys[mid] < c) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return NULL;
+}
+
+// Find the child for one byte of a folded word (NULL if absent)
+static TrieNode* getChild(TrieNode *node, unsigned char c) {
+    TrieNode **slot = getChildSlot(node, c);
+    return (slot != NULL) ? *slot : NULL;
+}
+
+// Get the child for a byte, creating it if the path doesn't exist
+static TrieNode* getOrCreateChild(TrieNode *node, unsigned char c) {
+    TrieNode *child = getChild(node, c);
+    if (child != NULL) {
+        return child;
     }
     
-    TrieNode *current = t->root;
+    if (c >= 'a' && c <= 'z') {
+        // Grow the letter array by one and open the slot for this letter
+        unsigned int bit = 1u << (c - 'a');
+        int n = __builtin_popcount(node->childMask);
+        int slot = __builtin_popcount(node->childMask & (bit - 1));
+        node->children = (TrieNode **)realloc(node->children, (n + 1) * sizeof(TrieNode *));
+        memmove(node->children + slot + 1, node->children + slot, (n - slot) * sizeof(TrieNode *));
+        child = createTrieNode();
+        node->children[slot] = child;
+        node->childMask |= bit;
+        return child;
+    }
     
-    // Traverse or create nodes for each character
-    for (int i = 0; word[i] != '\0'; i++) {
-        int index = tolower(word[i]) - 'a';
-        
-        // Check if character is valid alphabet
-        if (index < 0 || index >= ALPHABET_SIZE) {
+    // Insert into the sorted child map
+    int n = node->extraCount;
+    node->extraKeys = (unsigned char *)realloc(node->extraKeys, (n + 1) * sizeof(unsigned char));
+    node->extraChildren = (TrieNode **)realloc(node->extraChildren, (n + 1) * sizeof(TrieNode *));
+    int i = n;
+    while (i > 0 && node->extraKeys[i - 1] > c) {
+        node->extraKeys[i] = node->extraKeys[i - 1];
+        node->extraChildren[i] = node->extraChildren[i - 1];
+        i--;
+    }
+    child = createTrieNode();
+    node->extraKeys[i] = c;
+    node->extraChildren[i] = child;
+    node->extraCount++;
+    return child;
+}
+
+// Follow word from node, folding case on the fly; returns NULL if the path is missing
+// ALGORITHM: ASCII bytes are folded by table lookup with no decoding; only
+// multi-byte characters are decoded, folded and re-encoded
+static TrieNode* walkFolded(TrieNode *node, const char *word) {
+    const unsigned char *p = (const unsigned char *)word;
+    int length = strlen(word);
+    int i = 0;
+    
+    while (i < length && node != NULL) {
+        if (p[i] < 0x80) {
+            node = getChild(node, asciiFoldTable[p[i]]);
+            i++;
             continue;
         }
         
-        // Create new node if path doesn't exist
-        if (current->children[index] == NULL) {
-            current->children[index] = createTrieNode();
+        unsigned int codePoint;
+        char encoded[UTF8_MAX_BYTES];
+        i += utf8Decode(word + i, length - i, &codePoint);
+        int size = utf8Encode(foldCodePoint(codePoint), encoded);
+        for (int j = 0; j < size && node != NULL; j++) {
+            node = getChild(node, (unsigned char)encoded[j]);
+        }
+    }
+    return node;
+}
+
+// Insert a word into the trie (stored case-folded, all characters kept)
+// CONCURRENCY: Path copying - the nodes along the word are copied, the copies
+// are linked up, and the new root is published with a single atomic store
+void insertWord(Trie *t, const char *word) {
+    if (word == NULL || strlen(word) == 0) {
+        return;
+    }
+    
+    char folded[TRIE_MAX_WORD];
+    int length = foldWord(word, strlen(word), folded, sizeof(folded));
+    if (length <= 0) {
+        return;
+    }
+    
+    pthread_mutex_lock(&t->writeLock);
+    unsigned long epoch = atomic_load(&t->globalEpoch);
+    
+    TrieNode *oldRoot = atomic_load(&t->root);
+    TrieNode *newRoot = copyTrieNode(oldRoot);
+    retireNode(t, oldRoot, epoch);
+    TrieNode *current = newRoot;
+    
+    // Copy existing nodes along the path, create the missing ones
+    for (int i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)folded[i];
+        TrieNode **slot = getChildSlot(current, c);
+        if (slot != NULL) {
+            TrieNode *old = *slot;
+            *slot = copyTrieNode(old);
+            retireNode(t, old, epoch);
+            current = *slot;
+        } else {
+            current = getOrCreateChild(current, c);
         }
-        
-        current = current->children[index];
     }
     
     // Mark end of word
     current->isEndOfWord = 1;
     current->frequency++;
+    
+    // Publish the new version, then start a new epoch
+    atomic_store(&t->root, newRoot);
+    atomic_fetch_add(&t->globalEpoch, 1);
+    reclaimRetired(t);
+    pthread_mutex_unlock(&t->writeLock);
 }
 
-// Search for a word in the trie
+// Search for a word in the trie (case-insensitive)
 int searchWordInTrie(Trie *t, const char *word) {
     if (word == NULL || strlen(word) == 0) {
         return 0;
     }
     
-    TrieNode *current = t->root;
-    
-    // Traverse the trie
-    for (int i = 0; word[i] != '\0'; i++) {
-        int index = tolower(word[i]) - 'a';
-        
-        if (index < 0 || index >= ALPHABET_SIZE) {
-            return 0;
-        }
-        
-        if (current->children[index] == NULL) {
-            return 0;  // Word not found
-        }
-        
-        current = current->children[index];
-    }
+    int slot;
+    TrieNode *root = beginTrieRead(t, &slot);
+    int found = searchWordInSnapshot(root, word);
+    endTrieRead(t, slot);
+    return found;
+}
+
+// Search a snapshot returned by beginTrieRead (lets bulk readers enter once)
+int searchWordInSnapshot(TrieNode *root, const char *word) {
+    TrieNode *current = walkFolded(root, word);
     
     // Check if it's a complete word
     return (current != NULL && current->isEndOfWord);
@@ -82,7 +285,7 @@ int searchWordInTrie(Trie *t, const char *word) {
 
 // Helper function to collect all words with given prefix
 void collectWords(TrieNode *node, char *prefix, int prefixLen, char suggestions[][50], int *count, int maxSuggestions) {
-    if (node == NULL || *count >= maxSuggestions) {
+    if (node == NULL || *count >= maxSuggestions || prefixLen >= 49) {
         return;
     }
     
@@ -93,13 +296,18 @@ void collectWords(TrieNode *node, char *prefix, int prefixLen, char suggestions[
         (*count)++;
     }
     
-    // Recursively search all children
+    // Recursively search all children (letters in alphabetical order first)
+    int slot = 0;
     for (int i = 0; i < ALPHABET_SIZE && *count < maxSuggestions; i++) {
-        if (node->children[i] != NULL) {
+        if (node->childMask & (1u << i)) {
             prefix[prefixLen] = 'a' + i;
-            collectWords(node->children[i], prefix, prefixLen + 1, suggestions, count, maxSuggestions);
+            collectWords(node->children[slot++], prefix, prefixLen + 1, suggestions, count, maxSuggestions);
         }
     }
+    for (int i = 0; i < node->extraCount && *count < maxSuggestions; i++) {
+        prefix[prefixLen] = (char)node->extraKeys[i];
+        collectWords(node->extraChildren[i], prefix, prefixLen + 1, suggestions, count, maxSuggestions);
+    }
 }
 
 // Get suggestions for a given prefix
@@ -109,28 +317,23 @@ void getSuggestions(Trie *t, const char *prefix, char suggestions[][50], int *co
     }
     
     *count = 0;
-    TrieNode *current = t->root;
     char word[50];
-    int prefixLen = 0;
     
-    // Traverse to the prefix node
-    for (int i = 0; prefix[i] != '\0'; i++) {
-        int index = tolower(prefix[i]) - 'a';
-        
-        if (index < 0 || index >= ALPHABET_SIZE) {
-            return;
-        }
-        
-        if (current->children[index] == NULL) {
-            return;  // No words with this prefix
-        }
-        
-        word[prefixLen++] = prefix[i];
-        current = current->children[index];
+    // Suggestions are spelled in folded form
+    int prefixLen = foldWord(prefix, strlen(prefix), word, sizeof(word));
+    if (prefixLen < 0) {
+        return;
     }
     
+    // Traverse to the prefix node
+    int slot;
+    TrieNode *current = walkFolded(beginTrieRead(t, &slot), word);
+    
     // Collect all words with this prefix
-    collectWords(current, word, prefixLen, suggestions, count, 10);
+    if (current != NULL) {
+        collectWords(current, word, prefixLen, suggestions, count, 10);
+    }
+    endTrieRead(t, slot);
 }
 
 // Free a trie node recursively
@@ -140,20 +343,34 @@ void freeTrieNode(TrieNode *node) {
     }
     
     // Recursively free all children
-    for (int i = 0; i < ALPHABET_SIZE; i++) {
-        if (node->children[i] != NULL) {
-            freeTrieNode(node->children[i]);
-        }
+    int letters = __builtin_popcount(node->childMask);
+    for (int i = 0; i < letters; i++) {
+        freeTrieNode(node->children[i]);
     }
+    free(node->children);
+    for (int i = 0; i < node->extraCount; i++) {
+        freeTrieNode(node->extraChildren[i]);
+    }
+    free(node->extraKeys);
+    free(node->extraChildren);
     
     free(node);
 }
 
-// Free the entire trie
+// Free the entire trie (no reader may be active)
 void freeTrie(Trie *t) {
-    if (t->root != NULL) {
-        freeTrieNode(t->root);
-        t->root = NULL;
+    TrieNode *root = atomic_load(&t->root);
+    if (root != NULL) {
+        freeTrieNode(root);
+        atomic_store(&t->root, NULL);
+        
+        while (t->retired != NULL) {
+            RetiredNode *r = t->retired;
+            t->retired = r->next;
+            freeTrieNodeShallow(r->node);
+            free(r);
+        }
+        pthread_mutex_destroy(&t->writeLock);
     }
 }
 
@@ -184,17 +401,12 @@ void loadDictionary(Trie *t, const char *filename) {
     }
     
     char word[100];
-    while (fscanf(file, "%s", word) != EOF) {
-        // Remove punctuation and convert to lowercase
-        int len = strlen(word);
-        for (int i = 0; i < len; i++) {
-            if (!isalpha(word[i])) {
-                word[i] = '\0';
-                break;
-            }
-            word[i] = tolower(word[i]);
-        }
-        if (strlen(word) > 0) {
+    while (fscanf(file, "%99s", word) != EOF) {
+        // Keep the leading word, dropping trailing punctuation (insertWord folds case)
+        int wordStart;
+        int wordEnd = nextWord(word, strlen(word), 0, &wordStart);
+        if (wordEnd > 0 && wordStart == 0) {
+            word[wordEnd] = '\0';
             insertWord(t, word);
         }
     }
@@ -203,3 +415,26 @@ void loadDictionary(Trie *t, const char *filename) {
     printf("Dictionary loaded successfully.\n");
 }
 
+// Bytes used by a node and everything below it
+static long nodeMemoryUsage(TrieNode *node) {
+    int letters = __builtin_popcount(node->childMask);
+    long total = sizeof(TrieNode) + letters * sizeof(TrieNode *) +
+                 node->extraCount * (sizeof(unsigned char) + sizeof(TrieNode *));
+    
+    for (int i = 0; i < letters; i++) {
+        total += nodeMemoryUsage(node->children[i]);
+    }
+    for (int i = 0; i < node->extraCount; i++) {
+        total += nodeMemoryUsage(node->extraChildren[i]);
+    }
+    return total;
+}
+
+// Approximate heap bytes held by the trie (excluding allocator overhead)
+long getTrieMemoryUsage(Trie *t) {
+    int slot;
+    TrieNode *root = beginTrieRead(t, &slot);
+    long total = (root != NULL) ? nodeMemoryUsage(root) : 0;
+    endTrieRead(t, slot);
+    return total;
+}
@@ -1,21 +1,54 @@
 #ifndef TRIE_H
 #define TRIE_H
 
+#include <pthread.h>
+#include <stdatomic.h>
+
 // Trie (Prefix Tree) data structure for SPELL CHECKER and SEARCH SUGGESTIONS
-// Each node represents a character in a word
+// Each node represents one byte of a case-folded UTF-8 word
 
 #define ALPHABET_SIZE 26
+#define TRIE_MAX_WORD 100  // Longest folded word (in bytes) stored or looked up
+#define TRIE_MAX_READERS 32 // Threads that can be inside a read section at once
 
 // Trie node structure
+// 'a'-'z' children are stored compactly: bit i of childMask says whether 'a'+i
+// exists, and its slot in children is the popcount of the lower bits. Every
+// other byte (digits, UTF-8 sequences) lives in a small sorted child map
 typedef struct TrieNode {
-    struct TrieNode *children[ALPHABET_SIZE];  // Array of pointers to child nodes
+    unsigned int childMask;             // Bitmap of existing 'a'-'z' children
+    struct TrieNode **children;         // Letter children, one per set bit, in order
+    unsigned char *extraKeys;           // Sorted non a-z child bytes
+    struct TrieNode **extraChildren;    // Child for each byte in extraKeys
+    int extraCount;                     // Number of non a-z children
     int isEndOfWord;  // 1 if this node marks the end of a word, 0 otherwise
     int frequency;    // Frequency of word (for suggestions)
 } TrieNode;
 
+// Node replaced by an insert, freed once no reader can still see it
+typedef struct RetiredNode {
+    TrieNode *node;             // Old copy (its children are shared, not owned)
+    unsigned long epoch;        // Epoch in which it was replaced
+    struct RetiredNode *next;
+} RetiredNode;
+
+// Per-reader epoch, padded to its own cache line
+typedef struct {
+    atomic_ulong epoch;         // Epoch at read-section entry, 0 if slot is free
+    char padding[64 - sizeof(atomic_ulong)];
+} TrieReaderSlot;
+
 // Trie structure
+// CONCURRENCY: Published nodes are never modified. insertWord copies the nodes
+// on the word's path and swaps the root atomically, so readers walk an immutable
+// snapshot without locks. Replaced nodes are reclaimed by epoch: a node retired
+// in epoch E is freed once every active reader entered after E
 typedef struct {
-    TrieNode *root;  // Root node of trie
+    _Atomic(TrieNode *) root;                  // Root node of the published trie
+    atomic_ulong globalEpoch;                  // Current epoch (starts at 1)
+    TrieReaderSlot readers[TRIE_MAX_READERS];  // Active readers
+    pthread_mutex_t writeLock;                 // Serializes writers only
+    RetiredNode *retired;                      // Nodes waiting to be freed (under writeLock)
 } Trie;
 
 // Function declarations
@@ -23,10 +56,14 @@ TrieNode* createTrieNode(void);
 void initTrie(Trie *t);
 void insertWord(Trie *t, const char *word);
 int searchWordInTrie(Trie *t, const char *word);
+TrieNode* beginTrieRead(Trie *t, int *slot);
+void endTrieRead(Trie *t, int slot);
+int searchWordInSnapshot(TrieNode *root, const char *word);
 void getSuggestions(Trie *t, const char *prefix, char suggestions[][50], int *count);
 void freeTrieNode(TrieNode *node);
 void freeTrie(Trie *t);
 void loadDictionary(Trie *t, const char *filename);
+long getTrieMemoryUsage(Trie *t);
 
 #endif
 
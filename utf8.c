@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utf8.h"
+
+// Class of every byte value (see BYTE_* in utf8.h)
+const unsigned char utf8ByteClass[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2
+};
+
+// Lowercase form of every ASCII byte
+const unsigned char asciiFoldTable[128] = {
+      0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,
+     16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,
+     32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,
+     48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,
+     64,  97,  98,  99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111,
+    112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122,  91,  92,  93,  94,  95,
+     96,  97,  98,  99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111,
+    112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126, 127
+};
+
+// Code point ranges counted as word characters beyond ASCII
+typedef struct {
+    unsigned int first;
+    unsigned int last;
+} CodePointRange;
+
+static const CodePointRange wordRanges[] = {
+    {0x00AA, 0x00AA}, {0x00B5, 0x00B5}, {0x00BA, 0x00BA},
+    {0x00C0, 0x00D6}, {0x00D8, 0x00F6}, {0x00F8, 0x02AF},   // Latin-1, Latin Extended, IPA
+    {0x0300, 0x036F},                                        // Combining diacritics
+    {0x0386, 0x0386}, {0x0388, 0x03FF},                      // Greek
+    {0x0400, 0x0481}, {0x048A, 0x052F},                      // Cyrillic
+    {0x0531, 0x0556}, {0x0561, 0x0587},                      // Armenian
+    {0x05D0, 0x05EA},                                        // Hebrew
+    {0x0620, 0x064A}, {0x0660, 0x0669},                      // Arabic
+    {0x0900, 0x097F},                                        // Devanagari
+    {0x0E01, 0x0E3A}, {0x0E40, 0x0E4E},                      // Thai
+    {0x1E00, 0x1FFF},                                        // Latin/Greek Extended Additional
+    {0x3041, 0x3096}, {0x30A1, 0x30FA},                      // Hiragana, Katakana
+    {0x4E00, 0x9FFF},                                        // CJK Unified Ideographs
+    {0xAC00, 0xD7A3}                                         // Hangul syllables
+};
+
+// Decode one UTF-8 character; returns the number of bytes used
+// Malformed input decodes to U+FFFD one byte at a time
+int utf8Decode(const char *s, int length, unsigned int *codePoint) {
+    const unsigned char *p = (const unsigned char *)s;
+    unsigned int c = p[0];
+    int need;
+    
+    if (c < 0x80) {
+        *codePoint = c;
+        return 1;
+    } else if (c >= 0xC2 && c <= 0xDF) {
+        need = 1;
+        c &= 0x1F;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        need = 2;
+        c &= 0x0F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        need = 3;
+        c &= 0x07;
+    } else {
+        *codePoint = 0xFFFD;
+        return 1;
+    }
+    
+    if (need >= length) {
+        *codePoint = 0xFFFD;
+        return 1;
+    }
+    for (int i = 1; i <= need; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            *codePoint = 0xFFFD;
+            return 1;
+        }
+        c = (c << 6) | (p[i] & 0x3F);
+    }
+    
+    // Reject overlong forms, surrogates and values past U+10FFFF
+    if ((need == 2 && c < 0x800) || (need == 3 && (c < 0x10000 || c > 0x10FFFF)) ||
+        (c >= 0xD800 && c <= 0xDFFF)) {
+        *codePoint = 0xFFFD;
+        return 1;
+    }
+    
+    *codePoint = c;
+    return need + 1;
+}
+
+// Encode a code point as UTF-8; returns the number of bytes written
+int utf8Encode(unsigned int codePoint, char *out) {
+    unsigned char *p = (unsigned char *)out;
+    if (codePoint < 0x80) {
+        p[0] = (unsigned char)codePoint;
+        return 1;
+    } else if (codePoint < 0x800) {
+        p[0] = (unsigned char)(0xC0 | (codePoint >> 6));
+        p[1] = (unsigned char)(0x80 | (codePoint & 0x3F));
+        return 2;
+    } else if (codePoint < 0x10000) {
+        p[0] = (unsigned char)(0xE0 | (codePoint >> 12));
+        p[1] = (unsigned char)(0x80 | ((codePoint >> 6) & 0x3F));
+        p[2] = (unsigned char)(0x80 | (codePoint & 0x3F));
+        return 3;
+    }
+    p[0] = (unsigned char)(0xF0 | (codePoint >> 18));
+    p[1] = (unsigned char)(0x80 | ((codePoint >> 12) & 0x3F));
+    p[2] = (unsigned char)(0x80 | ((codePoint >> 6) & 0x3F));
+    p[3] = (unsigned char)(0x80 | (codePoint & 0x3F));
+    return 4;
+}
+
+// Check whether a byte can be part of a word without decoding
+// Multi-byte sequences count, so scans over raw bytes never split a character
+int isWordByte(unsigned char c) {
+    return utf8ByteClass[c] != BYTE_SEPARATOR;
+}
+
+// Check whether a code point is a letter, digit or combining mark
+// ALGORITHM: Binary search over the sorted range table - O(log r)
+int isWordCodePoint(unsigned int codePoint) {
+    if (codePoint < 0x80) {
+        return utf8ByteClass[codePoint] == BYTE_WORD;
+    }
+    
+    int lo = 0;
+    int hi = (int)(sizeof(wordRanges) / sizeof(wordRanges[0])) - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (codePoint < wordRanges[mid].first) {
+            hi = mid - 1;
+        } else if (codePoint > wordRanges[mid].last) {
+            lo = mid + 1;
+        } else {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Simple case folding for Latin, Greek, Cyrillic and Armenian
+unsigned int foldCodePoint(unsigned int c) {
+    if (c < 0x80) {
+        return asciiFoldTable[c];
+    }
+    if (c >= 0x00C0 && c <= 0x00DE && c != 0x00D7) {
+        return c + 0x20;
+    }
+    if (c >= 0x0100 && c <= 0x017F) {
+        if (c == 0x0130) return 0x0069;
+        if (c == 0x0178) return 0x00FF;
+        if ((c >= 0x0139 && c <= 0x0148) || (c >= 0x0179 && c <= 0x017E)) {
+            return (c & 1) ? c + 1 : c;
+        }
+        if (c != 0x0131 && c != 0x0138 && c != 0x0149 && c != 0x017F) {
+            return (c & 1) ? c : c + 1;
+        }
+        return c;
+    }
+    if (c >= 0x0391 && c <= 0x03A9 && c != 0x03A2) {
+        return c + 0x20;
+    }
+    if (c == 0x0386) return 0x03AC;
+    if (c >= 0x0388 && c <= 0x038A) return c + 0x25;
+    if (c == 0x038C) return 0x03CC;
+    if (c == 0x038E || c == 0x038F) return c + 0x3F;
+    if (c >= 0x0410 && c <= 0x042F) {
+        return c + 0x20;
+    }
+    if (c >= 0x0400 && c <= 0x040F) {
+        return c + 0x50;
+    }
+    if ((c >= 0x0460 && c <= 0x0481) || (c >= 0x048A && c <= 0x04BF)) {
+        return (c & 1) ? c : c + 1;
+    }
+    if (c >= 0x0531 && c <= 0x0556) {
+        return c + 0x30;
+    }
+    return c;
+}
+
+// Find the next word at or after pos; returns its end (exclusive) and sets
+// wordStart, or returns -1 when no word is left
+// ALGORITHM: ASCII bytes go through utf8ByteClass; only multi-byte
+// sequences are decoded, so ASCII text never leaves the table path
+int nextWord(const char *text, int length, int pos, int *wordStart) {
+    const unsigned char *p = (const unsigned char *)text;
+    unsigned int codePoint;
+    int start = -1;
+    
+    while (pos < length) {
+        unsigned char cls = utf8ByteClass[p[pos]];
+        int isWord;
+        int size = 1;
+        
+        if (cls == BYTE_MULTI) {
+            size = utf8Decode(text + pos, length - pos, &codePoint);
+            isWord = isWordCodePoint(codePoint);
+        } else {
+            isWord = (cls == BYTE_WORD);
+        }
+        
+        if (isWord) {
+            if (start == -1) {
+                start = pos;
+            }
+        } else if (start != -1) {
+            break;
+        }
+        pos += size;
+    }
+    
+    if (start == -1) {
+        return -1;
+    }
+    *wordStart = start;
+    return pos;
+}
+
+// Write the case-folded UTF-8 form of word[0..length) into out
+// Returns the folded length, or -1 if it does not fit in outSize (with the null)
+int foldWord(const char *word, int length, char *out, int outSize) {
+    const unsigned char *p = (const unsigned char *)word;
+    int n = 0;
+    int i = 0;
+    
+    while (i < length) {
+        if (p[i] < 0x80) {
+            if (n + 1 >= outSize) {
+                return -1;
+            }
+            out[n++] = (char)asciiFoldTable[p[i]];
+            i++;
+            continue;
+        }
+        
+        unsigned int codePoint;
+        char encoded[UTF8_MAX_BYTES];
+        i += utf8Decode(word + i, length - i, &codePoint);
+        int size = utf8Encode(foldCodePoint(codePoint), encoded);
+        if (n + size >= outSize) {
+            return -1;
+        }
+        memcpy(out + n, encoded, size);
+        n += size;
+    }
+    
+    out[n] = '\0';
+    return n;
+}
@@ -0,0 +1,27 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+// UTF-8 TOKENIZER and case folding for spell checking and word statistics
+// ASCII bytes are classified and folded through lookup tables; other code
+// points are decoded and classified with a sorted range table
+
+#define UTF8_MAX_BYTES 4
+
+// Byte classes from utf8ByteClass
+#define BYTE_SEPARATOR 0   // ASCII punctuation, whitespace, control
+#define BYTE_WORD      1   // ASCII letter or digit
+#define BYTE_MULTI     2   // Part of a multi-byte sequence (needs decoding)
+
+extern const unsigned char utf8ByteClass[256];
+extern const unsigned char asciiFoldTable[128];
+
+// Function declarations
+int utf8Decode(const char *s, int length, unsigned int *codePoint);
+int utf8Encode(unsigned int codePoint, char *out);
+int isWordByte(unsigned char c);
+int isWordCodePoint(unsigned int codePoint);
+unsigned int foldCodePoint(unsigned int codePoint);
+int nextWord(const char *text, int length, int pos, int *wordStart);
+int foldWord(const char *word, int length, char *out, int outSize);
+
+#endif
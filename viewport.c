@@ -0,0 +1,275 @@
+#define _DEFAULT_SOURCE   // strdup (POSIX, not declared under -std=c11)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include "viewport.h"
+
+// ========== BUFFERS ==========
+
+// Append n bytes to a growable buffer
+static void appendBytes(char **buffer, int *length, int *capacity, const char *bytes, int n) {
+    if (*length + n + 1 > *capacity) {
+        int newCapacity = (*capacity == 0) ? 256 : *capacity;
+        while (*length + n + 1 > newCapacity) {
+            newCapacity *= 2;
+        }
+        *buffer = (char *)realloc(*buffer, newCapacity);
+        *capacity = newCapacity;
+    }
+    memcpy(*buffer + *length, bytes, n);
+    *length += n;
+    (*buffer)[*length] = '\0';
+}
+
+static void appendFrame(Viewport *vp, const char *bytes, int n) {
+    appendBytes(&vp->frame, &vp->frameLength, &vp->frameCapacity, bytes, n);
+}
+
+// Write the frame with a single write() (after anything already buffered by stdio)
+static void flushFrame(Viewport *vp) {
+    fflush(stdout);
+    int written = 0;
+    while (written < vp->frameLength) {
+        ssize_t n = write(vp->fd, vp->frame + written, vp->frameLength - written);
+        if (n <= 0) {
+            break;
+        }
+        written += (int)n;
+    }
+    vp->frameLength = 0;
+}
+
+// ========== VIEWPORT ==========
+
+// Initialize a viewport of rows x cols
+void initViewport(Viewport *vp, int rows, int cols, int ansi) {
+    vp->editor = NULL;
+    vp->topLine = 0;
+    vp->leftCol = 0;
+    vp->rows = 0;
+    vp->cols = 0;
+    vp->ansi = ansi;
+    vp->placeCursor = 0;
+    vp->fd = STDOUT_FILENO;
+    vp->message[0] = '\0';
+    vp->drawn = NULL;
+    vp->row = NULL;
+    vp->rowCapacity = 0;
+    vp->frame = NULL;
+    vp->frameLength = 0;
+    vp->frameCapacity = 0;
+    resizeViewport(vp, rows, cols);
+}
+
+// Forget what is on screen; the next frame redraws every row
+void invalidateViewport(Viewport *vp) {
+    if (vp->drawn == NULL) {
+        return;
+    }
+    for (int r = 0; r <= vp->rows; r++) {
+        free(vp->drawn[r]);
+        vp->drawn[r] = NULL;
+    }
+}
+
+// Change the screen size (forces a full redraw)
+void resizeViewport(Viewport *vp, int rows, int cols) {
+    invalidateViewport(vp);
+    free(vp->drawn);
+    vp->rows = (rows < 1) ? 1 : rows;
+    vp->cols = (cols < 8) ? 8 : cols;
+    vp->drawn = (char **)calloc(vp->rows + 1, sizeof(char *));
+}
+
+// Size of the terminal on fd; returns 0 when fd is not a terminal
+int getTerminalSize(int fd, int *rows, int *cols) {
+    struct winsize ws;
+    if (!isatty(fd) || ioctl(fd, TIOCGWINSZ, &ws) == -1 || ws.ws_col == 0) {
+        return 0;
+    }
+    *rows = ws.ws_row;
+    *cols = ws.ws_col;
+    return 1;
+}
+
+// Scroll so the cursor line and column are on screen
+static void scrollToCursor(Viewport *vp, int cursorLine, int cursorCol) {
+    if (cursorLine < vp->topLine) {
+        vp->topLine = cursorLine;
+    } else if (cursorLine >= vp->topLine + vp->rows) {
+        vp->topLine = cursorLine - vp->rows + 1;
+    }
+
+    // One column is kept for the cursor drawn past the end of the line
+    if (cursorCol < vp->leftCol) {
+        vp->leftCol = cursorCol;
+    } else if (cursorCol >= vp->leftCol + vp->cols - 1) {
+        vp->leftCol = cursorCol - vp->cols + 2;
+    }
+}
+
+// Add one visible character to the row being built
+static void appendCell(Viewport *vp, int *length, char c, int isCursor) {
+    if (c == '\t') {
+        c = ' ';   // One column per character, so tabs are drawn as a single space
+    } else if ((unsigned char)c < 32 || c == 127) {
+        c = '?';
+    }
+
+    if (!isCursor) {
+        appendBytes(&vp->row, length, &vp->rowCapacity, &c, 1);
+    } else if (vp->ansi) {
+        appendBytes(&vp->row, length, &vp->rowCapacity, "\x1b[7m", 4);   // Reverse video
+        appendBytes(&vp->row, length, &vp->rowCapacity, &c, 1);
+        appendBytes(&vp->row, length, &vp->rowCapacity, "\x1b[27m", 5);
+    } else {
+        appendBytes(&vp->row, length, &vp->rowCapacity, "|", 1);
+        appendBytes(&vp->row, length, &vp->rowCapacity, &c, 1);
+    }
+}
+
+// Emit the finished row r: plain frames print every row, terminal frames only changed ones
+static void emitRow(Viewport *vp, int r, int length) {
+    if (!vp->ansi) {
+        appendFrame(vp, vp->row, length);
+        appendFrame(vp, "\n", 1);
+        return;
+    }
+    if (vp->drawn[r] != NULL && strcmp(vp->drawn[r], vp->row) == 0) {
+        return;
+    }
+
+    char move[32];
+    int n = snprintf(move, sizeof(move), "\x1b[%d;1H", r + 1);
+    appendFrame(vp, move, n);
+    appendFrame(vp, vp->row, length);
+    appendFrame(vp, "\x1b[K", 3);   // Clear the rest of the old row
+
+    free(vp->drawn[r]);
+    vp->drawn[r] = strdup(vp->row);
+}
+
+// Draw the visible part of the document
+// ALGORITHM: The line index gives the cursor line and the first visible line in
+// O(log n); the nodes of the visible lines are then walked once from the node
+// nearest to the top line, so the cost depends on the screen, not the file
+// (characters of long lines scrolled off to the side are still walked)
+// Returns the number of rows written
+int renderViewport(Viewport *vp, Editor *e) {
+    LineCache *lc = refreshLexedLines(e);
+    int lineCount = getCachedLineCount(lc);
+
+    if (vp->editor != e) {
+        // Another tab: its scroll position starts at the top
+        vp->editor = e;
+        vp->topLine = 0;
+        vp->leftCol = 0;
+        invalidateViewport(vp);
+    }
+
+    int cursorLineStart = 0;
+    int cursorLine = findLineAt(lc, e->cursorPos, &cursorLineStart);
+    int cursorCol = e->cursorPos - cursorLineStart;
+    scrollToCursor(vp, cursorLine, cursorCol);
+
+    int lastLine = vp->topLine + vp->rows;
+    if (lastLine > lineCount) {
+        lastLine = lineCount;
+    }
+
+    int written = 0;
+    if (!vp->ansi) {
+        char header[96];
+        int n = snprintf(header, sizeof(header), "\n--- Text Editor Content (lines %d-%d of %d) ---\n",
+                         vp->topLine + 1, lastLine, lineCount);
+        appendFrame(vp, header, n);
+    } else {
+        appendFrame(vp, "\x1b[?25l", 6);   // Hide the cursor while drawing
+    }
+
+    Node *node = getNodeBefore(e, getLineStart(lc, vp->topLine))->next;
+    for (int r = 0; r < vp->rows; r++) {
+        int index = vp->topLine + r;
+        int length = 0;
+        appendBytes(&vp->row, &length, &vp->rowCapacity, "", 0);   // Empty row
+
+        if (index >= lineCount) {
+            if (!vp->ansi) {
+                break;   // Plain frames stop at the end of the document
+            }
+            appendBytes(&vp->row, &length, &vp->rowCapacity, "~", 1);
+        } else {
+            LineEntry *line = getCachedLine(lc, index);
+            int textLength = (index < lineCount - 1) ? line->length - 1 : line->length;
+            int visibleEnd = vp->leftCol + vp->cols;
+
+            for (int j = 0; j < line->length && node != e->tail; j++) {
+                if (j < textLength && j >= vp->leftCol && j < visibleEnd) {
+                    appendCell(vp, &length, node->data, index == cursorLine && j == cursorCol);
+                }
+                node = node->next;
+            }
+            if (index == cursorLine && cursorCol == textLength) {
+                if (vp->ansi) {
+                    appendCell(vp, &length, ' ', 1);
+                } else {
+                    appendBytes(&vp->row, &length, &vp->rowCapacity, "|", 1);
+                }
+            }
+        }
+
+        emitRow(vp, r, length);
+        written++;
+    }
+
+    // Status line
+    char status[128];
+    int statusLength = snprintf(status, sizeof(status), "Ln %d, Col %d | Characters: %d | Lines: %d%s%s",
+                                cursorLine + 1, cursorCol + 1, e->length, lineCount,
+                                vp->message[0] ? " | " : "", vp->message);
+    if (statusLength >= (int)sizeof(status)) {
+        statusLength = sizeof(status) - 1;
+    }
+    if (vp->ansi && statusLength > vp->cols) {
+        statusLength = vp->cols;   // A wrapped status line would scroll the screen
+    }
+    if (!vp->ansi) {
+        appendFrame(vp, "--- End of Content ---\n", 23);
+        appendFrame(vp, status, statusLength);
+        appendFrame(vp, "\n\n", 2);
+    } else {
+        int length = 0;
+        appendBytes(&vp->row, &length, &vp->rowCapacity, "\x1b[7m", 4);
+        appendBytes(&vp->row, &length, &vp->rowCapacity, status, statusLength);
+        appendBytes(&vp->row, &length, &vp->rowCapacity, "\x1b[27m", 5);
+        emitRow(vp, vp->rows, length);
+
+        char move[32];
+        int n;
+        if (vp->placeCursor) {
+            n = snprintf(move, sizeof(move), "\x1b[%d;%dH", cursorLine - vp->topLine + 1,
+                         cursorCol - vp->leftCol + 1);
+        } else {
+            n = snprintf(move, sizeof(move), "\x1b[%d;1H", vp->rows + 2);
+        }
+        appendFrame(vp, move, n);
+        appendFrame(vp, "\x1b[?25h", 6);
+    }
+
+    flushFrame(vp);
+    return written;
+}
+
+// Free the viewport's buffers
+void freeViewport(Viewport *vp) {
+    invalidateViewport(vp);
+    free(vp->drawn);
+    free(vp->row);
+    free(vp->frame);
+    vp->drawn = NULL;
+    vp->row = NULL;
+    vp->frame = NULL;
+}
@@ -0,0 +1,40 @@
+#ifndef VIEWPORT_H
+#define VIEWPORT_H
+
+#include "editor.h"
+
+// VIEWPORT RENDERER
+// Draws only the lines that fit on screen, found through the line cache's
+// line index, so a redraw costs O(screen) instead of O(document)
+// On a terminal, rows are compared with what was last drawn and only changed
+// rows are rewritten; the whole frame goes out in a single write()
+
+// Viewport structure
+typedef struct {
+    const Editor *editor; // Editor shown by the last frame (scroll state belongs to it)
+    int topLine;          // First document line on screen
+    int leftCol;          // First column on screen
+    int rows;             // Text rows (the status line is drawn below them)
+    int cols;             // Columns per row
+    int ansi;             // 1: cursor-addressed diffed updates, 0: plain text frames
+    int placeCursor;      // ANSI only: leave the terminal cursor on the editor cursor
+    int fd;               // Descriptor frames are written to (stdout by default)
+    char message[128];    // Shown after the status line until replaced ("" for none)
+
+    char **drawn;         // Row contents as last written (NULL = unknown), rows + 1 entries
+    char *row;            // Scratch buffer for the row being built
+    int rowCapacity;
+    char *frame;          // Output of one frame, flushed with one write()
+    int frameLength;
+    int frameCapacity;
+} Viewport;
+
+// Function declarations
+void initViewport(Viewport *vp, int rows, int cols, int ansi);
+void resizeViewport(Viewport *vp, int rows, int cols);
+void invalidateViewport(Viewport *vp);
+int renderViewport(Viewport *vp, Editor *e);
+int getTerminalSize(int fd, int *rows, int *cols);
+void freeViewport(Viewport *vp);
+
+#endif